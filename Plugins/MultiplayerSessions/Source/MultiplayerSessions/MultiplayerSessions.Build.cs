@@ -30,7 +30,9 @@ public class MultiplayerSessions : ModuleRules
 				"OnlineSubsystemSteam",
 				"UMG",
 				"Slate",
-				"SlateCore"
+				"SlateCore",
+				"Sockets",
+				"Networking"
 				// ... add other public dependencies that you statically link with here ...
 			}
 			);
@@ -41,6 +43,8 @@ public class MultiplayerSessions : ModuleRules
 			{
 				"CoreUObject",
 				"Engine",
+				"Json",
+				"Projects",
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
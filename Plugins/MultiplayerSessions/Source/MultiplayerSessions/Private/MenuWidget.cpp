@@ -19,6 +19,11 @@ void UMenuWidget::NativeConstruct()
 	{
 		JoinButton->OnClicked.AddDynamic(this, &UMenuWidget::OnJoinButtonClicked);
 	}
+
+	if (PartyButton)
+	{
+		PartyButton->OnClicked.AddDynamic(this, &UMenuWidget::OnPartyButtonClicked);
+	}
 }
 
 void UMenuWidget::NativeDestruct()
@@ -49,19 +54,64 @@ void UMenuWidget::OnMultiplayerSessionsFound(const TArray<FOnlineSessionSearchRe
 		return;
 	}
 
+	// A party leader only takes sessions the whole party fits into, members then follow without searching
+	const int32 RequiredSlots = MultiplayerSessionsSubsystem->IsPartyLeader() ? MultiplayerSessionsSubsystem->GetPartySize() : 1;
+
+	TArray<FOnlineSessionSearchResult> Candidates;
 	for (const FOnlineSessionSearchResult& SearchResult : SearchResults)
 	{
-		FString ResultMatchType;
-		SearchResult.Session.SessionSettings.Get(TEXT("MatchType"), ResultMatchType);
+		if (!UMultiplayerSessionsSubsystem::HasOpenSlots(SearchResult, RequiredSlots))
+		{
+			continue;
+		}
 
-		if (ResultMatchType == MatchType)
+		FMultiplayerSessionAttributes ResultAttributes;
+		if (!FMultiplayerSessionAttributes::ReadFrom(SearchResult.Session.SessionSettings, ResultAttributes))
 		{
-			MultiplayerSessionsSubsystem->JoinSession(SearchResult);
-			return;
+			continue;
+		}
+
+		if (SessionAttributes.IsCompatibleWith(ResultAttributes))
+		{
+			Candidates.Add(SearchResult);
 		}
 	}
 
-	EnableButtons();
+	// Backend order is arbitrary, so the probe budget goes to the compatible sessions with the best advertised ping
+	Candidates.StableSort([](const FOnlineSessionSearchResult& A, const FOnlineSessionSearchResult& B)
+	{
+		return A.PingInMs < B.PingInMs;
+	});
+
+	if (Candidates.Num() > MaxQosCandidates)
+	{
+		Candidates.SetNum(MaxQosCandidates);
+	}
+
+	if (Candidates.IsEmpty())
+	{
+		EnableButtons();
+		return;
+	}
+
+	if (Candidates.Num() == 1)
+	{
+		MultiplayerSessionsSubsystem->JoinSession(Candidates[0]);
+		return;
+	}
+
+	MultiplayerSessionsSubsystem->RankSessionsByQos(Candidates);
+}
+
+void UMenuWidget::OnMultiplayerSessionsRanked(const TArray<FOnlineSessionSearchResult>& RankedResults)
+{
+	if (!MultiplayerSessionsSubsystem || RankedResults.IsEmpty())
+	{
+		EnableButtons();
+		return;
+	}
+
+	MultiplayerSessionsSubsystem->JoinSession(RankedResults[0]);
 }
 
 void UMenuWidget::OnMultiplayerSessionJoined(const EOnJoinSessionCompleteResult::Type Result)
@@ -84,7 +134,7 @@ void UMenuWidget::OnMultiplayerSessionJoined(const EOnJoinSessionCompleteResult:
 
 	if (APlayerController* PlayerController = GetGameInstance()->GetFirstLocalPlayerController())
 	{
-		PlayerController->ClientTravel(Address, TRAVEL_Absolute);
+		PlayerController->ClientTravel(Address + MultiplayerSessionsSubsystem->GetPartyTravelOptions(), TRAVEL_Absolute);
 		return;
 	}
 
@@ -99,7 +149,14 @@ void UMenuWidget::OnMultiplayerSessionStarted(const FName SessionName, const boo
 {
 }
 
-void UMenuWidget::SetupMenu(const int32 NewMaxSearchSessions, const FString& NewMatchType, const FString& NewPathToLobby)
+void UMenuWidget::OnMultiplayerPartyConnectTargetReceived(const FString& ConnectString)
+{
+	// The subsystem travels on its own, the menu only stops offering choices that are about to be left behind
+	DisableButtons();
+}
+
+void UMenuWidget::SetupMenu(const int32 NewMaxSearchSessions, const FString& NewMatchType, const FString& NewPathToLobby,
+	const int32 NewMapId, const int32 NewRegion, const int32 NewSkillBand, const int32 NewModeFlags)
 {
 	AddToViewport();
 	SetVisibility(ESlateVisibility::Visible);
@@ -107,6 +164,11 @@ void UMenuWidget::SetupMenu(const int32 NewMaxSearchSessions, const FString& New
 
 	MaxSessionSearches = NewMaxSearchSessions;
 	MatchType = NewMatchType;
+	SessionAttributes = FMultiplayerSessionAttributes(MatchType);
+	SessionAttributes.SetMapId(NewMapId);
+	SessionAttributes.SetRegion(NewRegion);
+	SessionAttributes.SetSkillBand(NewSkillBand);
+	SessionAttributes.SetModeFlags(static_cast<EMultiplayerSessionModeFlags>(NewModeFlags & 0xFF));
 	PathToLobby = NewPathToLobby;
 
 	if (APlayerController* PlayerController = GetWorld()->GetFirstPlayerController())
@@ -123,9 +185,11 @@ void UMenuWidget::SetupMenu(const int32 NewMaxSearchSessions, const FString& New
 	{
 		MultiplayerSessionsSubsystem->OnMultiplayerSessionCreatedDelegate.AddDynamic(this, &UMenuWidget::OnMultiplayerSessionCreated);
 		MultiplayerSessionsSubsystem->OnMultiplayerFindSessionsComplete.AddUObject(this, &UMenuWidget::OnMultiplayerSessionsFound);
+		MultiplayerSessionsSubsystem->OnMultiplayerSessionsRanked.AddUObject(this, &UMenuWidget::OnMultiplayerSessionsRanked);
 		MultiplayerSessionsSubsystem->OnMultiplayerJoinSessionComplete.AddUObject(this, &UMenuWidget::OnMultiplayerSessionJoined);
 		MultiplayerSessionsSubsystem->OnMultiplayerSessionDestroyed.AddDynamic(this, &UMenuWidget::OnMultiplayerSessionDestroyed);
 		MultiplayerSessionsSubsystem->OnMultiplayerSessionStarted.AddDynamic(this, &UMenuWidget::OnMultiplayerSessionStarted);
+		MultiplayerSessionsSubsystem->OnMultiplayerPartyConnectTargetReceived.AddUObject(this, &UMenuWidget::OnMultiplayerPartyConnectTargetReceived);
 	}
 }
 
@@ -144,7 +208,8 @@ void UMenuWidget::OnHostButtonClicked()
 {
 	if (MultiplayerSessionsSubsystem)
 	{
-		MultiplayerSessionsSubsystem->RequestCreateSession(4, MatchType);
+		const int32 NumPublicConnections = FMath::Max(4, MultiplayerSessionsSubsystem->GetPartySize());
+		MultiplayerSessionsSubsystem->RequestCreateSession(NumPublicConnections, SessionAttributes);
 		DisableButtons();
 	}
 }
@@ -159,6 +224,23 @@ void UMenuWidget::OnJoinButtonClicked()
 	}
 }
 
+void UMenuWidget::OnPartyButtonClicked()
+{
+	if (!MultiplayerSessionsSubsystem)
+	{
+		return;
+	}
+
+	if (MultiplayerSessionsSubsystem->IsInParty())
+	{
+		MultiplayerSessionsSubsystem->DestroyPartySession();
+	}
+	else
+	{
+		MultiplayerSessionsSubsystem->CreatePartySession(MaxPartySize);
+	}
+}
+
 void UMenuWidget::EnableButtons()
 {
 	if (HostButton)
@@ -0,0 +1,128 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MultiplayerSessionAttributes.h"
+
+#include "OnlineSessionSettings.h"
+#include "Misc/NetworkVersion.h"
+
+namespace MultiplayerSessionAttributes
+{
+	constexpr uint32 VersionShift = 0;
+	constexpr uint32 MatchTypeShift = 4;
+	constexpr uint32 MapShift = 20;
+	constexpr uint32 RegionShift = 32;
+	constexpr uint32 BuildShift = 36;
+	constexpr uint32 SkillBandShift = 52;
+	constexpr uint32 ModeFlagsShift = 56;
+
+	FORCEINLINE uint64 ReadBits(const uint64 Packed, const uint32 Shift, const uint64 Mask)
+	{
+		return (Packed >> Shift) & Mask;
+	}
+}
+
+FMultiplayerSessionAttributes::FMultiplayerSessionAttributes(const FString& MatchType)
+	: MatchTypeId(MakeMatchTypeId(MatchType))
+	, BuildId(GetLocalBuildId())
+{
+}
+
+uint16 FMultiplayerSessionAttributes::MakeMatchTypeId(const FString& MatchType)
+{
+	const uint32 Crc = FCrc::StrCrc32(*MatchType);
+	return static_cast<uint16>((Crc ^ (Crc >> 16)) & 0xFFFF);
+}
+
+uint16 FMultiplayerSessionAttributes::GetLocalBuildId()
+{
+	const uint32 NetworkVersion = FNetworkVersion::GetLocalNetworkVersion();
+	return static_cast<uint16>((NetworkVersion ^ (NetworkVersion >> 16)) & 0xFFFF);
+}
+
+void FMultiplayerSessionAttributes::SetMapId(const int32 InMapId)
+{
+	MapId = static_cast<uint16>(FMath::Clamp<int32>(InMapId, 0, MaxMapId));
+}
+
+void FMultiplayerSessionAttributes::SetRegion(const int32 InRegion)
+{
+	Region = static_cast<uint8>(FMath::Clamp<int32>(InRegion, 0, MaxRegion));
+}
+
+void FMultiplayerSessionAttributes::SetSkillBand(const int32 InSkillBand)
+{
+	SkillBand = static_cast<uint8>(FMath::Clamp<int32>(InSkillBand, 0, MaxSkillBand));
+}
+
+void FMultiplayerSessionAttributes::SetModeFlags(const EMultiplayerSessionModeFlags InModeFlags)
+{
+	ModeFlags = InModeFlags;
+}
+
+int64 FMultiplayerSessionAttributes::Pack() const
+{
+	using namespace MultiplayerSessionAttributes;
+
+	uint64 Packed = 0;
+	Packed |= static_cast<uint64>(SchemaVersion & 0xF) << VersionShift;
+	Packed |= static_cast<uint64>(MatchTypeId) << MatchTypeShift;
+	Packed |= static_cast<uint64>(FMath::Min(MapId, MaxMapId)) << MapShift;
+	Packed |= static_cast<uint64>(FMath::Min(Region, MaxRegion)) << RegionShift;
+	Packed |= static_cast<uint64>(BuildId) << BuildShift;
+	Packed |= static_cast<uint64>(FMath::Min(SkillBand, MaxSkillBand)) << SkillBandShift;
+	Packed |= static_cast<uint64>(ModeFlags) << ModeFlagsShift;
+
+	return static_cast<int64>(Packed);
+}
+
+bool FMultiplayerSessionAttributes::Unpack(const int64 PackedValue, FMultiplayerSessionAttributes& OutAttributes)
+{
+	using namespace MultiplayerSessionAttributes;
+
+	const uint64 Packed = static_cast<uint64>(PackedValue);
+	if (ReadBits(Packed, VersionShift, 0xF) != SchemaVersion)
+	{
+		return false;
+	}
+
+	OutAttributes.MatchTypeId = static_cast<uint16>(ReadBits(Packed, MatchTypeShift, 0xFFFF));
+	OutAttributes.MapId = static_cast<uint16>(ReadBits(Packed, MapShift, MaxMapId));
+	OutAttributes.Region = static_cast<uint8>(ReadBits(Packed, RegionShift, MaxRegion));
+	OutAttributes.BuildId = static_cast<uint16>(ReadBits(Packed, BuildShift, 0xFFFF));
+	OutAttributes.SkillBand = static_cast<uint8>(ReadBits(Packed, SkillBandShift, MaxSkillBand));
+	OutAttributes.ModeFlags = static_cast<EMultiplayerSessionModeFlags>(ReadBits(Packed, ModeFlagsShift, 0xFF));
+
+	return true;
+}
+
+void FMultiplayerSessionAttributes::WriteTo(FOnlineSessionSettings& SessionSettings) const
+{
+	SessionSettings.Set(SETTING_PACKED_SESSION_ATTRIBUTES, Pack(), EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+}
+
+bool FMultiplayerSessionAttributes::ReadFrom(const FOnlineSessionSettings& SessionSettings, FMultiplayerSessionAttributes& OutAttributes)
+{
+	int64 PackedValue = 0;
+	if (!SessionSettings.Get(SETTING_PACKED_SESSION_ATTRIBUTES, PackedValue))
+	{
+		return false;
+	}
+
+	return Unpack(PackedValue, OutAttributes);
+}
+
+bool FMultiplayerSessionAttributes::IsCompatibleWith(const FMultiplayerSessionAttributes& Other) const
+{
+	if (MatchTypeId != Other.MatchTypeId || BuildId != Other.BuildId)
+	{
+		return false;
+	}
+
+	if ((MapId != 0 && MapId != Other.MapId) || (Region != 0 && Region != Other.Region) || (SkillBand != 0 && SkillBand != Other.SkillBand))
+	{
+		return false;
+	}
+
+	return EnumHasAllFlags(Other.ModeFlags, ModeFlags);
+}
@@ -0,0 +1,236 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MultiplayerSessionsBackendTrace.h"
+
+#include "MultiplayerSessions.h"
+#include "Containers/Ticker.h"
+#include "Dom/JsonObject.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+namespace MultiplayerSessionsBackendTrace
+{
+	constexpr int32 FileVersion = 1;
+}
+
+const TCHAR* LexToString(const EMultiplayerSessionsBackendOp Operation)
+{
+	switch (Operation)
+	{
+	case EMultiplayerSessionsBackendOp::Create:		return TEXT("Create");
+	case EMultiplayerSessionsBackendOp::Destroy:	return TEXT("Destroy");
+	case EMultiplayerSessionsBackendOp::Find:		return TEXT("Find");
+	case EMultiplayerSessionsBackendOp::Join:		return TEXT("Join");
+	case EMultiplayerSessionsBackendOp::Update:		return TEXT("Update");
+	}
+
+	return TEXT("Unknown");
+}
+
+bool LexTryParseString(EMultiplayerSessionsBackendOp& OutOperation, const TCHAR* String)
+{
+	for (const EMultiplayerSessionsBackendOp Operation : { EMultiplayerSessionsBackendOp::Create, EMultiplayerSessionsBackendOp::Destroy,
+		EMultiplayerSessionsBackendOp::Find, EMultiplayerSessionsBackendOp::Join, EMultiplayerSessionsBackendOp::Update })
+	{
+		if (FCString::Stricmp(String, LexToString(Operation)) == 0)
+		{
+			OutOperation = Operation;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+FMultiplayerSessionsBackendRecorder::FMultiplayerSessionsBackendRecorder()
+	: StartTime(FPlatformTime::Seconds())
+{
+}
+
+int32 FMultiplayerSessionsBackendRecorder::RecordCall(const EMultiplayerSessionsBackendOp Operation, const FName SessionName, const FString& Arguments)
+{
+	FMultiplayerSessionsBackendEvent& Event = Events.AddDefaulted_GetRef();
+	Event.Operation = Operation;
+	Event.SessionName = SessionName;
+	Event.Arguments = Arguments;
+	Event.CallTime = FPlatformTime::Seconds() - StartTime;
+	Event.bCallAccepted = true;
+
+	const int32 EventIndex = Events.Num() - 1;
+	PendingEventIndices.FindOrAdd({ Operation, SessionName }).Add(EventIndex);
+
+	return EventIndex;
+}
+
+void FMultiplayerSessionsBackendRecorder::RecordCallRejected(const int32 EventIndex)
+{
+	if (!Events.IsValidIndex(EventIndex))
+	{
+		return;
+	}
+
+	// Rejected calls complete synchronously in the caller and are reproduced by replaying the rejection
+	FMultiplayerSessionsBackendEvent& Event = Events[EventIndex];
+	Event.bCallAccepted = false;
+
+	if (TArray<int32>* PendingIndices = PendingEventIndices.Find({ Event.Operation, Event.SessionName }))
+	{
+		PendingIndices->Remove(EventIndex);
+	}
+}
+
+void FMultiplayerSessionsBackendRecorder::RecordCompletion(const EMultiplayerSessionsBackendOp Operation, const FName SessionName, const bool bWasSuccessful, const int32 ResultCode, const int32 ResultSize)
+{
+	TArray<int32>* PendingIndices = PendingEventIndices.Find({ Operation, SessionName });
+	if (!PendingIndices || PendingIndices->IsEmpty())
+	{
+		return;
+	}
+
+	FMultiplayerSessionsBackendEvent& Event = Events[(*PendingIndices)[0]];
+	PendingIndices->RemoveAt(0);
+
+	Event.Latency = FPlatformTime::Seconds() - StartTime - Event.CallTime;
+	Event.bWasSuccessful = bWasSuccessful;
+	Event.ResultCode = ResultCode;
+	Event.ResultSize = ResultSize;
+}
+
+bool FMultiplayerSessionsBackendRecorder::SaveToFile(const FString& FilePath) const
+{
+	TArray<TSharedPtr<FJsonValue>> EventValues;
+	for (const FMultiplayerSessionsBackendEvent& Event : Events)
+	{
+		const TSharedRef<FJsonObject> EventObject = MakeShared<FJsonObject>();
+		EventObject->SetStringField(TEXT("Op"), LexToString(Event.Operation));
+		EventObject->SetStringField(TEXT("Session"), Event.SessionName.ToString());
+		EventObject->SetStringField(TEXT("Args"), Event.Arguments);
+		EventObject->SetNumberField(TEXT("CallTime"), Event.CallTime);
+		EventObject->SetBoolField(TEXT("Accepted"), Event.bCallAccepted);
+		EventObject->SetNumberField(TEXT("Latency"), Event.Latency);
+		EventObject->SetBoolField(TEXT("Success"), Event.bWasSuccessful);
+		EventObject->SetNumberField(TEXT("Result"), Event.ResultCode);
+		EventObject->SetNumberField(TEXT("ResultSize"), Event.ResultSize);
+		EventValues.Add(MakeShared<FJsonValueObject>(EventObject));
+	}
+
+	const TSharedRef<FJsonObject> RootObject = MakeShared<FJsonObject>();
+	RootObject->SetNumberField(TEXT("Version"), MultiplayerSessionsBackendTrace::FileVersion);
+	RootObject->SetArrayField(TEXT("Events"), EventValues);
+
+	FString Output;
+	const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Output);
+	if (!FJsonSerializer::Serialize(RootObject, Writer))
+	{
+		return false;
+	}
+
+	return FFileHelper::SaveStringToFile(Output, *FilePath);
+}
+
+FMultiplayerSessionsBackendReplay::~FMultiplayerSessionsBackendReplay()
+{
+	// Handles of completions that already fired are simply not found any more
+	for (const FTSTicker::FDelegateHandle& Handle : CompletionTickerHandles)
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(Handle);
+	}
+}
+
+bool FMultiplayerSessionsBackendReplay::LoadFromFile(const FString& FilePath)
+{
+	QueuedEvents.Reset();
+	ActiveSessions.Reset();
+
+	FString Input;
+	if (!FFileHelper::LoadFileToString(Input, *FilePath))
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Could not read session backend trace %s"), *FilePath);
+		return false;
+	}
+
+	TSharedPtr<FJsonObject> RootObject;
+	const TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Input);
+	if (!FJsonSerializer::Deserialize(Reader, RootObject) || !RootObject.IsValid()
+		|| RootObject->GetIntegerField(TEXT("Version")) != MultiplayerSessionsBackendTrace::FileVersion)
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Session backend trace %s is malformed or from another version"), *FilePath);
+		return false;
+	}
+
+	for (const TSharedPtr<FJsonValue>& EventValue : RootObject->GetArrayField(TEXT("Events")))
+	{
+		const TSharedPtr<FJsonObject> EventObject = EventValue->AsObject();
+		if (!EventObject.IsValid())
+		{
+			continue;
+		}
+
+		FMultiplayerSessionsBackendEvent Event;
+		if (!LexTryParseString(Event.Operation, *EventObject->GetStringField(TEXT("Op"))))
+		{
+			continue;
+		}
+
+		Event.SessionName = FName(*EventObject->GetStringField(TEXT("Session")));
+		Event.Arguments = EventObject->GetStringField(TEXT("Args"));
+		Event.CallTime = EventObject->GetNumberField(TEXT("CallTime"));
+		Event.bCallAccepted = EventObject->GetBoolField(TEXT("Accepted"));
+		Event.Latency = EventObject->GetNumberField(TEXT("Latency"));
+		Event.bWasSuccessful = EventObject->GetBoolField(TEXT("Success"));
+		Event.ResultCode = EventObject->GetIntegerField(TEXT("Result"));
+		Event.ResultSize = EventObject->GetIntegerField(TEXT("ResultSize"));
+
+		QueuedEvents.FindOrAdd({ Event.Operation, Event.SessionName }).Add(MoveTemp(Event));
+	}
+
+	return true;
+}
+
+bool FMultiplayerSessionsBackendReplay::Call(const EMultiplayerSessionsBackendOp Operation, const FName SessionName, FOnReplayedCompletion&& OnCompletion)
+{
+	TArray<FMultiplayerSessionsBackendEvent>* Queue = QueuedEvents.Find({ Operation, SessionName });
+	if (!Queue || Queue->IsEmpty())
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Session backend trace has no more %s calls for %s, rejecting"), LexToString(Operation), *SessionName.ToString());
+		return false;
+	}
+
+	const FMultiplayerSessionsBackendEvent Event = (*Queue)[0];
+	Queue->RemoveAt(0);
+
+	if (Event.bCallAccepted && Event.HasCompleted())
+	{
+		CompletionTickerHandles.Add(FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([Event, OnCompletion = MoveTemp(OnCompletion)](float)
+		{
+			OnCompletion(Event);
+			return false;
+		}), static_cast<float>(Event.Latency)));
+	}
+
+	return Event.bCallAccepted;
+}
+
+void FMultiplayerSessionsBackendReplay::ApplyCompletion(const FMultiplayerSessionsBackendEvent& Event)
+{
+	if (!Event.bWasSuccessful)
+	{
+		return;
+	}
+
+	switch (Event.Operation)
+	{
+	case EMultiplayerSessionsBackendOp::Create:
+	case EMultiplayerSessionsBackendOp::Join:
+		ActiveSessions.Add(Event.SessionName);
+		break;
+	case EMultiplayerSessionsBackendOp::Destroy:
+		ActiveSessions.Remove(Event.SessionName);
+		break;
+	default:
+		break;
+	}
+}
@@ -0,0 +1,255 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MultiplayerSessionsQos.h"
+
+#include "IPAddress.h"
+#include "MultiplayerSessions.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "Common/UdpSocketBuilder.h"
+#include "Common/UdpSocketReceiver.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+
+namespace MultiplayerSessionsQos
+{
+	constexpr uint32 PacketMagic = 0x4D505153; // 'MPQS'
+	constexpr double LossPenaltyMs = 500.0;
+
+	/** Magic, target index, sequence and send time. Replies are an unmodified echo, so no byte order handling is needed */
+	struct FProbePacket
+	{
+		uint32 Magic = PacketMagic;
+		uint16 TargetIndex = 0;
+		uint16 Sequence = 0;
+		double SendTime = 0.0;
+	};
+}
+
+double FMultiplayerSessionQosResult::GetAverageRttMs() const
+{
+	return PacketsReceived > 0 ? TotalRttMs / PacketsReceived : MAX_dbl;
+}
+
+double FMultiplayerSessionQosResult::GetLossRatio() const
+{
+	return PacketsSent > 0 ? 1.0 - static_cast<double>(PacketsReceived) / PacketsSent : 1.0;
+}
+
+double FMultiplayerSessionQosResult::GetScore() const
+{
+	if (!WasReached())
+	{
+		return MAX_dbl;
+	}
+
+	return GetAverageRttMs() + GetLossRatio() * MultiplayerSessionsQos::LossPenaltyMs;
+}
+
+FMultiplayerSessionsQosResponder::~FMultiplayerSessionsQosResponder()
+{
+	Stop();
+}
+
+bool FMultiplayerSessionsQosResponder::Start(const int32 FirstPort, const int32 MaxPortAttempts)
+{
+	Stop();
+
+	// Never reuse the address: two hosts sharing a port would each receive some of the other's probes
+	for (int32 Attempt = 0; Attempt < FMath::Max(1, MaxPortAttempts) && !Socket; ++Attempt)
+	{
+		Socket = FUdpSocketBuilder(TEXT("MultiplayerSessionsQosResponder"))
+			.AsNonBlocking()
+			.BoundToPort(FirstPort + Attempt)
+			.Build();
+	}
+
+	if (!Socket)
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Failed to bind QoS responder to any of ports %d-%d"), FirstPort, FirstPort + FMath::Max(1, MaxPortAttempts) - 1);
+		return false;
+	}
+
+	BoundPort = Socket->GetPortNo();
+
+	Receiver = MakeUnique<FUdpSocketReceiver>(Socket, FTimespan::FromMilliseconds(100), TEXT("MultiplayerSessionsQosResponder"));
+	Receiver->OnDataReceived().BindRaw(this, &FMultiplayerSessionsQosResponder::OnDataReceived);
+	Receiver->Start();
+
+	return true;
+}
+
+void FMultiplayerSessionsQosResponder::Stop()
+{
+	// The receiver thread must be gone before the socket it reads from
+	Receiver.Reset();
+
+	if (Socket)
+	{
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+		Socket = nullptr;
+	}
+
+	BoundPort = 0;
+}
+
+void FMultiplayerSessionsQosResponder::OnDataReceived(const FArrayReaderPtr& Data, const FIPv4Endpoint& Sender)
+{
+	using namespace MultiplayerSessionsQos;
+
+	if (!Data.IsValid() || Data->Num() != sizeof(FProbePacket))
+	{
+		return;
+	}
+
+	FProbePacket Packet;
+	FMemory::Memcpy(&Packet, Data->GetData(), sizeof(FProbePacket));
+	if (Packet.Magic != PacketMagic)
+	{
+		return;
+	}
+
+	int32 BytesSent = 0;
+	Socket->SendTo(Data->GetData(), Data->Num(), BytesSent, *Sender.ToInternetAddr());
+}
+
+FMultiplayerSessionsQosProbe::~FMultiplayerSessionsQosProbe()
+{
+	Cancel();
+}
+
+bool FMultiplayerSessionsQosProbe::Start(const TArray<TSharedRef<FInternetAddr>>& Targets, FOnMultiplayerQosProbeComplete&& InOnComplete, const int32 InPacketsPerTarget, const float DeadlineSeconds)
+{
+	using namespace MultiplayerSessionsQos;
+
+	Cancel();
+
+	PacketsPerTarget = FMath::Clamp(InPacketsPerTarget, 1, 32);
+	if (Targets.IsEmpty() || Targets.Num() > MAX_uint16)
+	{
+		return false;
+	}
+
+	Socket = FUdpSocketBuilder(TEXT("MultiplayerSessionsQosProbe"))
+		.AsNonBlocking()
+		.Build();
+
+	if (!Socket)
+	{
+		return false;
+	}
+
+	OnComplete = MoveTemp(InOnComplete);
+	Results.Init(FMultiplayerSessionQosResult(), Targets.Num());
+	ReceivedSequenceMasks.Init(0, Targets.Num());
+	OutstandingPackets = 0;
+
+	// Every packet leaves before any reply is awaited, so all targets share the same deadline
+	for (int32 TargetIndex = 0; TargetIndex < Targets.Num(); ++TargetIndex)
+	{
+		for (int32 Sequence = 0; Sequence < PacketsPerTarget; ++Sequence)
+		{
+			FProbePacket Packet;
+			Packet.TargetIndex = static_cast<uint16>(TargetIndex);
+			Packet.Sequence = static_cast<uint16>(Sequence);
+			Packet.SendTime = FPlatformTime::Seconds();
+
+			int32 BytesSent = 0;
+			if (Socket->SendTo(reinterpret_cast<const uint8*>(&Packet), sizeof(FProbePacket), BytesSent, *Targets[TargetIndex]))
+			{
+				++Results[TargetIndex].PacketsSent;
+				++OutstandingPackets;
+			}
+		}
+	}
+
+	DeadlineTime = FPlatformTime::Seconds() + DeadlineSeconds;
+	TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FMultiplayerSessionsQosProbe::Tick));
+
+	return true;
+}
+
+void FMultiplayerSessionsQosProbe::Cancel()
+{
+	if (TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+
+	OnComplete.Unbind();
+	CloseSocket();
+}
+
+bool FMultiplayerSessionsQosProbe::Tick(float DeltaTime)
+{
+	ReceivePendingReplies();
+
+	if (OutstandingPackets > 0 && FPlatformTime::Seconds() < DeadlineTime)
+	{
+		return true;
+	}
+
+	Finish();
+	return false;
+}
+
+void FMultiplayerSessionsQosProbe::ReceivePendingReplies()
+{
+	using namespace MultiplayerSessionsQos;
+
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	const TSharedRef<FInternetAddr> Sender = SocketSubsystem->CreateInternetAddr();
+
+	uint32 PendingDataSize = 0;
+	while (Socket->HasPendingData(PendingDataSize))
+	{
+		FProbePacket Packet;
+		int32 BytesRead = 0;
+		if (!Socket->RecvFrom(reinterpret_cast<uint8*>(&Packet), sizeof(FProbePacket), BytesRead, *Sender))
+		{
+			break;
+		}
+
+		if (BytesRead != sizeof(FProbePacket) || Packet.Magic != PacketMagic
+			|| !Results.IsValidIndex(Packet.TargetIndex) || Packet.Sequence >= PacketsPerTarget)
+		{
+			continue;
+		}
+
+		const uint32 SequenceBit = 1u << Packet.Sequence;
+		if (ReceivedSequenceMasks[Packet.TargetIndex] & SequenceBit)
+		{
+			continue;
+		}
+
+		ReceivedSequenceMasks[Packet.TargetIndex] |= SequenceBit;
+
+		FMultiplayerSessionQosResult& Result = Results[Packet.TargetIndex];
+		++Result.PacketsReceived;
+		Result.TotalRttMs += (FPlatformTime::Seconds() - Packet.SendTime) * 1000.0;
+		--OutstandingPackets;
+	}
+}
+
+void FMultiplayerSessionsQosProbe::Finish()
+{
+	// The completion callback may destroy this probe, so nothing may touch members after it runs
+	TickerHandle.Reset();
+	CloseSocket();
+
+	FOnMultiplayerQosProbeComplete Callback = MoveTemp(OnComplete);
+	const TArray<FMultiplayerSessionQosResult> FinalResults = MoveTemp(Results);
+	Callback.ExecuteIfBound(FinalResults);
+}
+
+void FMultiplayerSessionsQosProbe::CloseSocket()
+{
+	if (Socket)
+	{
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+		Socket = nullptr;
+	}
+}
@@ -3,7 +3,14 @@
 
 #include "MultiplayerSessionsSubsystem.h"
 
+#include "MultiplayerSessions.h"
 #include "OnlineSubsystem.h"
+#include "IPAddress.h"
+#include "SocketSubsystem.h"
+#include "Engine/GameInstance.h"
+#include "Engine/NetDriver.h"
+#include "GameFramework/PlayerController.h"
+#include "ProfilingDebugging/MiscTrace.h"
 
 UMultiplayerSessionsSubsystem::UMultiplayerSessionsSubsystem()
 {
@@ -12,13 +19,41 @@ UMultiplayerSessionsSubsystem::UMultiplayerSessionsSubsystem()
 void UMultiplayerSessionsSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
 	Super::Initialize(Collection);
-	
+
+	// The default platform service is started when the OnlineSubsystem module loads, before any game instance exists,
+	// so this is only a lookup and the service's own startup cost shows up in the engine's module loading instead
 	if (const IOnlineSubsystem* OnlineSubsystem = IOnlineSubsystem::Get())
 	{
 		OnlineSessionInterface = OnlineSubsystem->GetSessionInterface();
+
+		TRACE_BOOKMARK(TEXT("MultiplayerSessions: %s available"), *OnlineSubsystem->GetSubsystemName().ToString());
+		UE_LOG(LogMultiplayerSessions, Log, TEXT("Online subsystem %s available %.2f s after process start"),
+			*OnlineSubsystem->GetSubsystemName().ToString(), FPlatformTime::Seconds() - GStartTime);
 	}
 
 	BindDelegates();
+
+	FString BackendTracePath;
+	if (FParse::Value(FCommandLine::Get(), TEXT("SessionTraceRecord="), BackendTracePath))
+	{
+		StartBackendRecording(BackendTracePath);
+	}
+
+	if (FParse::Value(FCommandLine::Get(), TEXT("SessionTraceReplay="), BackendTracePath))
+	{
+		StartBackendReplay(BackendTracePath);
+	}
+}
+
+void UMultiplayerSessionsSubsystem::Deinitialize()
+{
+	QosProbe.Reset();
+	StopQosResponder();
+
+	StopBackendRecording();
+	StopBackendReplay();
+
+	Super::Deinitialize();
 }
 
 void UMultiplayerSessionsSubsystem::BindDelegates()
@@ -39,28 +74,258 @@ void UMultiplayerSessionsSubsystem::BindDelegates()
 
 		const auto OnStartSessionCompleteDelegate = FOnStartSessionCompleteDelegate::CreateUObject(this, &UMultiplayerSessionsSubsystem::OnStartSessionComplete);
 		OnlineSessionInterface->AddOnStartSessionCompleteDelegate_Handle(OnStartSessionCompleteDelegate);
+
+		const auto OnUpdateSessionCompleteDelegate = FOnUpdateSessionCompleteDelegate::CreateUObject(this, &UMultiplayerSessionsSubsystem::OnUpdateSessionComplete);
+		OnlineSessionInterface->AddOnUpdateSessionCompleteDelegate_Handle(OnUpdateSessionCompleteDelegate);
+
+		const auto OnSessionSettingsUpdatedDelegate = FOnSessionSettingsUpdatedDelegate::CreateUObject(this, &UMultiplayerSessionsSubsystem::OnSessionSettingsUpdated);
+		OnlineSessionInterface->AddOnSessionSettingsUpdatedDelegate_Handle(OnSessionSettingsUpdatedDelegate);
+
+		const auto OnSessionUserInviteAcceptedDelegate = FOnSessionUserInviteAcceptedDelegate::CreateUObject(this, &UMultiplayerSessionsSubsystem::OnSessionUserInviteAccepted);
+		OnlineSessionInterface->AddOnSessionUserInviteAcceptedDelegate_Handle(OnSessionUserInviteAcceptedDelegate);
+
+		const auto OnSessionParticipantJoinedDelegate = FOnSessionParticipantJoinedDelegate::CreateUObject(this, &UMultiplayerSessionsSubsystem::OnSessionParticipantJoined);
+		OnlineSessionInterface->AddOnSessionParticipantJoinedDelegate_Handle(OnSessionParticipantJoinedDelegate);
+
+		const auto OnSessionParticipantLeftDelegate = FOnSessionParticipantLeftDelegate::CreateUObject(this, &UMultiplayerSessionsSubsystem::OnSessionParticipantLeft);
+		OnlineSessionInterface->AddOnSessionParticipantLeftDelegate_Handle(OnSessionParticipantLeftDelegate);
+	}
+}
+
+bool UMultiplayerSessionsSubsystem::BackendCreateSession(const FUniqueNetIdPtr& HostingPlayerId, const FName SessionName, const FOnlineSessionSettings& NewSessionSettings)
+{
+	const int32 EventIndex = BackendRecorder ? BackendRecorder->RecordCall(EMultiplayerSessionsBackendOp::Create, SessionName,
+		FString::Printf(TEXT("NumPublicConnections=%d bIsLANMatch=%d"), NewSessionSettings.NumPublicConnections, NewSessionSettings.bIsLANMatch)) : INDEX_NONE;
+
+	const bool bCallAccepted = BackendReplay
+		? ReplayBackendCall(EMultiplayerSessionsBackendOp::Create, SessionName)
+		: HostingPlayerId.IsValid() && OnlineSessionInterface->CreateSession(*HostingPlayerId, SessionName, NewSessionSettings);
+
+	if (!bCallAccepted && BackendRecorder)
+	{
+		BackendRecorder->RecordCallRejected(EventIndex);
+	}
+
+	return bCallAccepted;
+}
+
+bool UMultiplayerSessionsSubsystem::BackendDestroySession(const FName SessionName)
+{
+	const int32 EventIndex = BackendRecorder ? BackendRecorder->RecordCall(EMultiplayerSessionsBackendOp::Destroy, SessionName, FString()) : INDEX_NONE;
+
+	const bool bCallAccepted = BackendReplay
+		? ReplayBackendCall(EMultiplayerSessionsBackendOp::Destroy, SessionName)
+		: OnlineSessionInterface->DestroySession(SessionName);
+
+	if (!bCallAccepted && BackendRecorder)
+	{
+		BackendRecorder->RecordCallRejected(EventIndex);
+	}
+
+	return bCallAccepted;
+}
+
+bool UMultiplayerSessionsSubsystem::BackendFindSessions(const FUniqueNetIdPtr& SearchingPlayerId, const TSharedRef<FOnlineSessionSearch>& SearchSettings)
+{
+	const int32 EventIndex = BackendRecorder ? BackendRecorder->RecordCall(EMultiplayerSessionsBackendOp::Find, NAME_None,
+		FString::Printf(TEXT("MaxSearchResults=%d bIsLanQuery=%d"), SearchSettings->MaxSearchResults, SearchSettings->bIsLanQuery)) : INDEX_NONE;
+
+	const bool bCallAccepted = BackendReplay
+		? ReplayBackendCall(EMultiplayerSessionsBackendOp::Find, NAME_None)
+		: SearchingPlayerId.IsValid() && OnlineSessionInterface->FindSessions(*SearchingPlayerId, SearchSettings);
+
+	if (!bCallAccepted && BackendRecorder)
+	{
+		BackendRecorder->RecordCallRejected(EventIndex);
 	}
+
+	return bCallAccepted;
+}
+
+bool UMultiplayerSessionsSubsystem::BackendJoinSession(const FUniqueNetIdPtr& PlayerId, const FName SessionName, const FOnlineSessionSearchResult& DesiredSession)
+{
+	const int32 EventIndex = BackendRecorder ? BackendRecorder->RecordCall(EMultiplayerSessionsBackendOp::Join, SessionName,
+		FString::Printf(TEXT("SessionId=%s"), *DesiredSession.GetSessionIdStr())) : INDEX_NONE;
+
+	const bool bCallAccepted = BackendReplay
+		? ReplayBackendCall(EMultiplayerSessionsBackendOp::Join, SessionName)
+		: PlayerId.IsValid() && OnlineSessionInterface->JoinSession(*PlayerId, SessionName, DesiredSession);
+
+	if (!bCallAccepted && BackendRecorder)
+	{
+		BackendRecorder->RecordCallRejected(EventIndex);
+	}
+
+	return bCallAccepted;
+}
+
+bool UMultiplayerSessionsSubsystem::BackendUpdateSession(const FName SessionName, FOnlineSessionSettings& UpdatedSessionSettings)
+{
+	const int32 EventIndex = BackendRecorder ? BackendRecorder->RecordCall(EMultiplayerSessionsBackendOp::Update, SessionName,
+		FString::Printf(TEXT("NumSettings=%d"), UpdatedSessionSettings.Settings.Num())) : INDEX_NONE;
+
+	const bool bCallAccepted = BackendReplay
+		? ReplayBackendCall(EMultiplayerSessionsBackendOp::Update, SessionName)
+		: OnlineSessionInterface->UpdateSession(SessionName, UpdatedSessionSettings, true);
+
+	if (!bCallAccepted && BackendRecorder)
+	{
+		BackendRecorder->RecordCallRejected(EventIndex);
+	}
+
+	return bCallAccepted;
+}
+
+bool UMultiplayerSessionsSubsystem::HasSessionBackend() const
+{
+	return BackendReplay.IsValid() || OnlineSessionInterface.IsValid();
+}
+
+bool UMultiplayerSessionsSubsystem::IsLanBackend() const
+{
+	const IOnlineSubsystem* OnlineSubsystem = OnlineSessionInterface.IsValid() ? IOnlineSubsystem::Get() : nullptr;
+	return OnlineSubsystem && OnlineSubsystem->GetSubsystemName() == "NULL";
+}
+
+FUniqueNetIdPtr UMultiplayerSessionsSubsystem::GetLocalPlayerId() const
+{
+	const ULocalPlayer* LocalPlayer = GetWorld() ? GetWorld()->GetFirstLocalPlayerFromController() : nullptr;
+	return LocalPlayer ? LocalPlayer->GetPreferredUniqueNetId().GetUniqueNetId() : FUniqueNetIdPtr();
+}
+
+bool UMultiplayerSessionsSubsystem::HasNamedSession(const FName SessionName) const
+{
+	if (BackendReplay)
+	{
+		return BackendReplay->HasSession(SessionName);
+	}
+
+	return OnlineSessionInterface.IsValid() && OnlineSessionInterface->GetNamedSession(SessionName) != nullptr;
+}
+
+bool UMultiplayerSessionsSubsystem::ReplayBackendCall(const EMultiplayerSessionsBackendOp Operation, const FName SessionName)
+{
+	return BackendReplay->Call(Operation, SessionName, [WeakThis = TWeakObjectPtr<UMultiplayerSessionsSubsystem>(this)](const FMultiplayerSessionsBackendEvent& Event)
+	{
+		if (WeakThis.IsValid())
+		{
+			WeakThis->DispatchReplayedCompletion(Event);
+		}
+	});
+}
+
+void UMultiplayerSessionsSubsystem::DispatchReplayedCompletion(const FMultiplayerSessionsBackendEvent& Event)
+{
+	if (!BackendReplay)
+	{
+		return;
+	}
+
+	BackendReplay->ApplyCompletion(Event);
+
+	switch (Event.Operation)
+	{
+	case EMultiplayerSessionsBackendOp::Create:
+		OnCreateSessionComplete(Event.SessionName, Event.bWasSuccessful);
+		break;
+	case EMultiplayerSessionsBackendOp::Destroy:
+		OnDestroySessionComplete(Event.SessionName, Event.bWasSuccessful);
+		break;
+	case EMultiplayerSessionsBackendOp::Find:
+		// Only the result count is captured, the placeholders keep result handling on the same code path
+		if (SessionSearchResults.IsValid())
+		{
+			SessionSearchResults->SearchResults.SetNum(Event.ResultSize);
+			OnFindSessionsComplete(Event.bWasSuccessful);
+		}
+		break;
+	case EMultiplayerSessionsBackendOp::Join:
+		OnJoinSessionComplete(Event.SessionName, static_cast<EOnJoinSessionCompleteResult::Type>(Event.ResultCode));
+		break;
+	case EMultiplayerSessionsBackendOp::Update:
+		OnUpdateSessionComplete(Event.SessionName, Event.bWasSuccessful);
+		break;
+	}
+}
+
+void UMultiplayerSessionsSubsystem::RecordBackendCompletion(const EMultiplayerSessionsBackendOp Operation, const FName SessionName, const bool bWasSuccessful, const int32 ResultCode, const int32 ResultSize)
+{
+	// A failure reported locally for a call that was rejected or never made must not complete some other pending call
+	if (bNextCompletionIsSynthetic)
+	{
+		bNextCompletionIsSynthetic = false;
+		return;
+	}
+
+	if (BackendRecorder)
+	{
+		BackendRecorder->RecordCompletion(Operation, SessionName, bWasSuccessful, ResultCode, ResultSize);
+	}
+}
+
+void UMultiplayerSessionsSubsystem::StartBackendRecording(const FString& FilePath)
+{
+	BackendRecorder = MakeUnique<FMultiplayerSessionsBackendRecorder>();
+	BackendRecordingPath = FilePath;
+}
+
+void UMultiplayerSessionsSubsystem::StopBackendRecording()
+{
+	if (!BackendRecorder)
+	{
+		return;
+	}
+
+	if (!BackendRecorder->SaveToFile(BackendRecordingPath))
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Failed to save session backend trace to %s"), *BackendRecordingPath);
+	}
+
+	BackendRecorder.Reset();
+	BackendRecordingPath.Empty();
+}
+
+bool UMultiplayerSessionsSubsystem::StartBackendReplay(const FString& FilePath)
+{
+	TUniquePtr<FMultiplayerSessionsBackendReplay> NewReplay = MakeUnique<FMultiplayerSessionsBackendReplay>();
+	if (!NewReplay->LoadFromFile(FilePath))
+	{
+		return false;
+	}
+
+	BackendReplay = MoveTemp(NewReplay);
+	return true;
+}
+
+void UMultiplayerSessionsSubsystem::StopBackendReplay()
+{
+	BackendReplay.Reset();
 }
 
 void UMultiplayerSessionsSubsystem::RequestCreateSession(const int32 NumPublicConnections, const FString& MatchType)
 {
-	if (!OnlineSessionInterface.IsValid() || !IOnlineSubsystem::Get())
+	RequestCreateSession(NumPublicConnections, FMultiplayerSessionAttributes(MatchType));
+}
+
+void UMultiplayerSessionsSubsystem::RequestCreateSession(const int32 NumPublicConnections, const FMultiplayerSessionAttributes& Attributes)
+{
+	if (!HasSessionBackend())
 	{
 		return;
 	}
 
-	if (OnlineSessionInterface->GetNamedSession(NAME_GameSession))
+	if (HasNamedSession(NAME_GameSession))
 	{
 		bCreateSessionOnDestroy = true;
 		LastCreateRequestPublicConnections = NumPublicConnections;
-		LastCreateRequestMatchType = MatchType;
+		LastCreateRequestAttributes = Attributes;
 		
 		DestroySession();
 		return;
 	}
 
 	SessionSettings = {};
-	SessionSettings.bIsLANMatch = IOnlineSubsystem::Get()->GetSubsystemName() == "NULL";
+	SessionSettings.bIsLANMatch = IsLanBackend();
 	SessionSettings.NumPublicConnections = NumPublicConnections;
 	SessionSettings.bAllowJoinInProgress = true;
 	SessionSettings.bAllowJoinViaPresence = true;
@@ -68,20 +333,30 @@ void UMultiplayerSessionsSubsystem::RequestCreateSession(const int32 NumPublicCo
 	SessionSettings.bUsesPresence = true;
 	SessionSettings.bUseLobbiesIfAvailable = true;
 	SessionSettings.BuildUniqueId = 1;
-	SessionSettings.Set(TEXT("MatchType"), MatchType, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
 
-	if (const ULocalPlayer* LocalPlayer = GetWorld()->GetFirstLocalPlayerFromController())
+	// Whatever the caller asked for, the session only advertises the build this host actually runs
+	SessionAttributes = Attributes;
+	SessionAttributes.BuildId = FMultiplayerSessionAttributes::GetLocalBuildId();
+	SessionAttributes.WriteTo(SessionSettings);
+
+	const bool bIsSuccessfulRequest = BackendCreateSession(GetLocalPlayerId(), NAME_GameSession, SessionSettings);
+	if (!bIsSuccessfulRequest)
 	{
-		const bool bIsSuccessfulRequest = OnlineSessionInterface->CreateSession(*LocalPlayer->GetPreferredUniqueNetId(), NAME_GameSession, SessionSettings);
-		if (!bIsSuccessfulRequest)
-		{
-			OnCreateSessionComplete(NAME_GameSession, false);
-		}
+		bNextCompletionIsSynthetic = true;
+		OnCreateSessionComplete(NAME_GameSession, false);
 	}
 }
 
 void UMultiplayerSessionsSubsystem::OnCreateSessionComplete(const FName SessionName, const bool bWasSuccessful)
 {
+	RecordBackendCompletion(EMultiplayerSessionsBackendOp::Create, SessionName, bWasSuccessful);
+
+	if (SessionName == NAME_PartySession)
+	{
+		HandlePartyCreateSessionComplete(bWasSuccessful);
+		return;
+	}
+
 	if (bWasSuccessful)
 	{
 		GEngine->AddOnScreenDebugMessage(INDEX_NONE, 15.f, FColor::Cyan, FString::Printf(TEXT("Created session: %s"), *SessionName.ToString()));
@@ -96,13 +371,13 @@ void UMultiplayerSessionsSubsystem::OnCreateSessionComplete(const FName SessionN
 
 void UMultiplayerSessionsSubsystem::DestroySession()
 {
-	if (!OnlineSessionInterface.IsValid())
+	if (!HasSessionBackend())
 	{
 		OnMultiplayerSessionDestroyed.Broadcast(false);
 		return;
 	}
 
-	if (!OnlineSessionInterface->DestroySession(NAME_GameSession))
+	if (!BackendDestroySession(NAME_GameSession))
 	{
 		OnMultiplayerSessionDestroyed.Broadcast(false);
 	}
@@ -110,10 +385,21 @@ void UMultiplayerSessionsSubsystem::DestroySession()
 
 void UMultiplayerSessionsSubsystem::OnDestroySessionComplete(const FName SessionName, const bool bWasSuccessful)
 {
+	RecordBackendCompletion(EMultiplayerSessionsBackendOp::Destroy, SessionName, bWasSuccessful);
+
+	if (SessionName == NAME_PartySession)
+	{
+		LastPartyConnectTarget.Empty();
+		PartyMemberIds.Reset();
+		return;
+	}
+
+	StopQosResponder();
+
 	if (bWasSuccessful && bCreateSessionOnDestroy)
 	{
 		bCreateSessionOnDestroy = false;
-		RequestCreateSession(LastCreateRequestPublicConnections, LastCreateRequestMatchType);
+		RequestCreateSession(LastCreateRequestPublicConnections, LastCreateRequestAttributes);
 	}
 
 	OnMultiplayerSessionDestroyed.Broadcast(bWasSuccessful);
@@ -123,23 +409,21 @@ void UMultiplayerSessionsSubsystem::FindSessions(const int32 MaxSearchResults)
 {
 	GEngine->AddOnScreenDebugMessage(INDEX_NONE, 90.f, FColor::Cyan, TEXT("FindSessions Called!!"));
 
-	if (!OnlineSessionInterface.IsValid() || !IOnlineSubsystem::Get())
+	if (!HasSessionBackend())
 	{
 		return;
 	}
 
 	SessionSearchResults = MakeShareable(new FOnlineSessionSearch());
 	SessionSearchResults->MaxSearchResults = MaxSearchResults;
-	SessionSearchResults->bIsLanQuery = IOnlineSubsystem::Get()->GetSubsystemName() == "NULL";
+	SessionSearchResults->bIsLanQuery = IsLanBackend();
 	SessionSearchResults->QuerySettings.Set(SEARCH_PRESENCE, true, EOnlineComparisonOp::Equals);
 
-	if (const ULocalPlayer* LocalPlayer = GetWorld()->GetFirstLocalPlayerFromController())
+	const bool bIsSuccessfulRequest = BackendFindSessions(GetLocalPlayerId(), SessionSearchResults.ToSharedRef());
+	if (!bIsSuccessfulRequest)
 	{
-		const bool bIsSuccessfulRequest = OnlineSessionInterface->FindSessions(*LocalPlayer->GetPreferredUniqueNetId(), SessionSearchResults.ToSharedRef());
-		if (!bIsSuccessfulRequest)
-		{
-			OnFindSessionsComplete(false);
-		}
+		bNextCompletionIsSynthetic = true;
+		OnFindSessionsComplete(false);
 	}
 }
 
@@ -147,30 +431,44 @@ void UMultiplayerSessionsSubsystem::OnFindSessionsComplete(const bool bWasSucces
 {
 	GEngine->AddOnScreenDebugMessage(INDEX_NONE, 90.f, FColor::Cyan, TEXT("OnFindSessionsComplete Called!!"));
 
-	const bool bValidResults = bWasSuccessful && SessionSearchResults->SearchResults.Num() <= 0;
+	RecordBackendCompletion(EMultiplayerSessionsBackendOp::Find, NAME_None, bWasSuccessful, 0, SessionSearchResults->SearchResults.Num());
+
+	const bool bValidResults = bWasSuccessful && SessionSearchResults->SearchResults.Num() > 0;
 	OnMultiplayerFindSessionsComplete.Broadcast(SessionSearchResults->SearchResults, bValidResults);
 }
 
 void UMultiplayerSessionsSubsystem::JoinSession(const FOnlineSessionSearchResult& SessionSearchResult)
 {
-	if (!OnlineSessionInterface)
+	if (!HasSessionBackend())
 	{
+		bNextCompletionIsSynthetic = true;
 		OnJoinSessionComplete(NAME_GameSession, EOnJoinSessionCompleteResult::UnknownError);
 		return;
 	}
 
-	if (const ULocalPlayer* LocalPlayer = GetWorld()->GetFirstLocalPlayerFromController())
+	const bool bIsSuccessfulRequest = BackendJoinSession(GetLocalPlayerId(), NAME_GameSession, SessionSearchResult);
+	if (!bIsSuccessfulRequest)
 	{
-		const bool bIsSuccessfulRequest = OnlineSessionInterface->JoinSession(*LocalPlayer->GetPreferredUniqueNetId(), NAME_GameSession, SessionSearchResult);
-		if (!bIsSuccessfulRequest)
-		{
-			OnJoinSessionComplete(NAME_GameSession, EOnJoinSessionCompleteResult::UnknownError);
-		}
+		bNextCompletionIsSynthetic = true;
+		OnJoinSessionComplete(NAME_GameSession, EOnJoinSessionCompleteResult::UnknownError);
 	}
 }
 
 void UMultiplayerSessionsSubsystem::OnJoinSessionComplete(const FName SessionName, EOnJoinSessionCompleteResult::Type Result)
 {
+	RecordBackendCompletion(EMultiplayerSessionsBackendOp::Join, SessionName, Result == EOnJoinSessionCompleteResult::Success, Result);
+
+	if (SessionName == NAME_PartySession)
+	{
+		HandlePartyJoinSessionComplete(Result);
+		return;
+	}
+
+	if (Result == EOnJoinSessionCompleteResult::Success)
+	{
+		PublishGameSessionToParty();
+	}
+
 	OnMultiplayerJoinSessionComplete.Broadcast(Result);
 }
 
@@ -182,6 +480,423 @@ void UMultiplayerSessionsSubsystem::OnStartSessionComplete(const FName SessionNa
 {
 }
 
+void UMultiplayerSessionsSubsystem::UpdateSessionPlayerCount(const int32 PlayerCount)
+{
+	if (!HasSessionBackend() || !HasNamedSession(NAME_GameSession))
+	{
+		return;
+	}
+
+	SessionSettings.Set(SETTING_SESSION_PLAYER_COUNT, PlayerCount, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+	SessionSettings.bAllowJoinInProgress = PlayerCount < SessionSettings.NumPublicConnections;
+
+	BackendUpdateSession(NAME_GameSession, SessionSettings);
+}
+
+void UMultiplayerSessionsSubsystem::OnUpdateSessionComplete(const FName SessionName, const bool bWasSuccessful)
+{
+	RecordBackendCompletion(EMultiplayerSessionsBackendOp::Update, SessionName, bWasSuccessful);
+
+	if (!bWasSuccessful)
+	{
+		GEngine->AddOnScreenDebugMessage(INDEX_NONE, 15.f, FColor::Red, FString::Printf(TEXT("Failed to update session: %s"), *SessionName.ToString()));
+	}
+}
+
+void UMultiplayerSessionsSubsystem::CreatePartySession(const int32 MaxPartySize)
+{
+	if (!HasSessionBackend())
+	{
+		OnMultiplayerPartySessionCreated.Broadcast(false);
+		return;
+	}
+
+	if (HasNamedSession(NAME_PartySession))
+	{
+		OnMultiplayerPartySessionCreated.Broadcast(false);
+		return;
+	}
+
+	PartySessionSettings = {};
+	PartySessionSettings.bIsLANMatch = IsLanBackend();
+	PartySessionSettings.NumPublicConnections = MaxPartySize;
+	PartySessionSettings.bAllowJoinInProgress = true;
+	PartySessionSettings.bAllowJoinViaPresence = true;
+	PartySessionSettings.bAllowInvites = true;
+	// Parties are only reached through invites and presence, never through a game session search
+	PartySessionSettings.bShouldAdvertise = false;
+	PartySessionSettings.bUsesPresence = true;
+	PartySessionSettings.bUseLobbiesIfAvailable = true;
+	PartySessionSettings.BuildUniqueId = 1;
+	PartySessionSettings.Set(SETTING_PARTY_SESSION, true, EOnlineDataAdvertisementType::ViaOnlineService);
+
+	PartyMemberIds.Reset();
+
+	const bool bIsSuccessfulRequest = BackendCreateSession(GetLocalPlayerId(), NAME_PartySession, PartySessionSettings);
+	if (!bIsSuccessfulRequest)
+	{
+		bNextCompletionIsSynthetic = true;
+		OnCreateSessionComplete(NAME_PartySession, false);
+	}
+}
+
+void UMultiplayerSessionsSubsystem::JoinPartySession(const FOnlineSessionSearchResult& PartySearchResult)
+{
+	if (!HasSessionBackend() || HasNamedSession(NAME_PartySession))
+	{
+		bNextCompletionIsSynthetic = true;
+		OnJoinSessionComplete(NAME_PartySession, EOnJoinSessionCompleteResult::AlreadyInSession);
+		return;
+	}
+
+	PartyMemberIds.Reset();
+
+	const bool bIsSuccessfulRequest = BackendJoinSession(GetLocalPlayerId(), NAME_PartySession, PartySearchResult);
+	if (!bIsSuccessfulRequest)
+	{
+		bNextCompletionIsSynthetic = true;
+		OnJoinSessionComplete(NAME_PartySession, EOnJoinSessionCompleteResult::UnknownError);
+	}
+}
+
+void UMultiplayerSessionsSubsystem::DestroyPartySession()
+{
+	if (HasSessionBackend())
+	{
+		BackendDestroySession(NAME_PartySession);
+	}
+}
+
+FString UMultiplayerSessionsSubsystem::GetPartyId() const
+{
+	if (!OnlineSessionInterface.IsValid())
+	{
+		return FString();
+	}
+
+	const FNamedOnlineSession* PartySession = OnlineSessionInterface->GetNamedSession(NAME_PartySession);
+	return PartySession && PartySession->SessionInfo.IsValid() ? PartySession->SessionInfo->GetSessionId().ToString() : FString();
+}
+
+FString UMultiplayerSessionsSubsystem::GetPartyTravelOptions() const
+{
+	const FString PartyId = GetPartyId();
+	if (PartyId.IsEmpty())
+	{
+		return FString();
+	}
+
+	// Every member sends the size, whoever of the party reaches the host first has the slots held for the rest
+	return FString::Printf(TEXT("?%s=%s?%s=%d"), PARTY_OPTION_ID, *PartyId, PARTY_OPTION_SIZE, GetPartySize());
+}
+
+void UMultiplayerSessionsSubsystem::PublishPartyConnectTarget(const FString& ConnectString)
+{
+	if (!IsPartyLeader())
+	{
+		return;
+	}
+
+	PartySessionSettings.Set(SETTING_PARTY_CONNECT_TARGET, ConnectString, EOnlineDataAdvertisementType::ViaOnlineService);
+	BackendUpdateSession(NAME_PartySession, PartySessionSettings);
+}
+
+void UMultiplayerSessionsSubsystem::NotifyListenServerReady()
+{
+	if (!OnlineSessionInterface.IsValid())
+	{
+		return;
+	}
+
+	const FNamedOnlineSession* GameSession = OnlineSessionInterface->GetNamedSession(NAME_GameSession);
+	if (!GameSession || !GameSession->bHosting)
+	{
+		return;
+	}
+
+	// Only a responder that actually bound is advertised, clients fall back to the backend's ping otherwise
+	if (StartQosResponder())
+	{
+		SessionSettings.Set(SETTING_QOS_PORT, QosResponder->GetPort(), EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+		BackendUpdateSession(NAME_GameSession, SessionSettings);
+	}
+
+	PublishGameSessionToParty();
+}
+
+void UMultiplayerSessionsSubsystem::OnSessionSettingsUpdated(const FName SessionName, const FOnlineSessionSettings& UpdatedSettings)
+{
+	if (SessionName == NAME_PartySession && !IsPartyLeader())
+	{
+		HandlePartyConnectTarget(UpdatedSettings);
+	}
+}
+
+void UMultiplayerSessionsSubsystem::OnSessionUserInviteAccepted(const bool bWasSuccessful, const int32 ControllerId, FUniqueNetIdPtr UserId, const FOnlineSessionSearchResult& InviteResult)
+{
+	if (!bWasSuccessful || !InviteResult.IsValid())
+	{
+		return;
+	}
+
+	bool bIsPartySession = false;
+	if (InviteResult.Session.SessionSettings.Get(SETTING_PARTY_SESSION, bIsPartySession) && bIsPartySession)
+	{
+		JoinPartySession(InviteResult);
+	}
+	else
+	{
+		JoinSession(InviteResult);
+	}
+}
+
+void UMultiplayerSessionsSubsystem::OnSessionParticipantJoined(const FName SessionName, const FUniqueNetId& UniqueId)
+{
+	if (SessionName != NAME_PartySession || IsLocalPlayerId(UniqueId))
+	{
+		return;
+	}
+
+	if (!PartyMemberIds.ContainsByPredicate([&UniqueId](const FUniqueNetIdRef& MemberId) { return *MemberId == UniqueId; }))
+	{
+		PartyMemberIds.Add(UniqueId.AsShared());
+	}
+}
+
+void UMultiplayerSessionsSubsystem::OnSessionParticipantLeft(const FName SessionName, const FUniqueNetId& UniqueId, EOnSessionParticipantLeftReason LeaveReason)
+{
+	if (SessionName == NAME_PartySession)
+	{
+		PartyMemberIds.RemoveAll([&UniqueId](const FUniqueNetIdRef& MemberId) { return *MemberId == UniqueId; });
+	}
+}
+
+void UMultiplayerSessionsSubsystem::HandlePartyCreateSessionComplete(const bool bWasSuccessful)
+{
+	if (!bWasSuccessful)
+	{
+		GEngine->AddOnScreenDebugMessage(INDEX_NONE, 15.f, FColor::Red, FString("Failed to create party!"));
+	}
+
+	OnMultiplayerPartySessionCreated.Broadcast(bWasSuccessful);
+}
+
+void UMultiplayerSessionsSubsystem::HandlePartyJoinSessionComplete(const EOnJoinSessionCompleteResult::Type Result)
+{
+	OnMultiplayerPartySessionJoined.Broadcast(Result);
+
+	// The leader may already be in a game, in which case we follow straight away
+	if (Result == EOnJoinSessionCompleteResult::Success && OnlineSessionInterface.IsValid())
+	{
+		if (const FOnlineSessionSettings* PartySettings = OnlineSessionInterface->GetSessionSettings(NAME_PartySession))
+		{
+			HandlePartyConnectTarget(*PartySettings);
+		}
+	}
+}
+
+void UMultiplayerSessionsSubsystem::HandlePartyConnectTarget(const FOnlineSessionSettings& PartySettings)
+{
+	FString ConnectTarget;
+	if (!PartySettings.Get(SETTING_PARTY_CONNECT_TARGET, ConnectTarget) || ConnectTarget.IsEmpty() || ConnectTarget == LastPartyConnectTarget)
+	{
+		return;
+	}
+
+	// Without a player controller to travel with, the target stays unrecorded so the next update can still be followed
+	APlayerController* PlayerController = GetGameInstance()->GetFirstLocalPlayerController();
+	if (!PlayerController)
+	{
+		return;
+	}
+
+	LastPartyConnectTarget = ConnectTarget;
+	OnMultiplayerPartyConnectTargetReceived.Broadcast(ConnectTarget);
+
+	PlayerController->ClientTravel(ConnectTarget + GetPartyTravelOptions(), TRAVEL_Absolute);
+}
+
+void UMultiplayerSessionsSubsystem::PublishGameSessionToParty()
+{
+	if (!IsPartyLeader())
+	{
+		return;
+	}
+
+	FString ConnectString;
+	if (OnlineSessionInterface->GetResolvedConnectString(NAME_GameSession, ConnectString))
+	{
+		PublishPartyConnectTarget(ConnectString);
+	}
+}
+
+bool UMultiplayerSessionsSubsystem::IsLocalPlayerId(const FUniqueNetId& UniqueId) const
+{
+	const FUniqueNetIdPtr LocalPlayerId = GetLocalPlayerId();
+	return LocalPlayerId.IsValid() && *LocalPlayerId == UniqueId;
+}
+
+void UMultiplayerSessionsSubsystem::RankSessionsByQos(const TArray<FOnlineSessionSearchResult>& Candidates)
+{
+	QosCandidates = Candidates;
+	QosProbedCandidateIndices.Reset();
+
+	// Order by the backend's ping first, it is the tiebreaker for hosts the probe cannot reach
+	QosCandidates.StableSort([](const FOnlineSessionSearchResult& A, const FOnlineSessionSearchResult& B)
+	{
+		return A.PingInMs < B.PingInMs;
+	});
+
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+
+	TArray<TSharedRef<FInternetAddr>> Targets;
+	for (int32 CandidateIndex = 0; CandidateIndex < QosCandidates.Num(); ++CandidateIndex)
+	{
+		const FOnlineSessionSearchResult& Candidate = QosCandidates[CandidateIndex];
+
+		int32 QosPort = 0;
+		FString ConnectString;
+		if (!OnlineSessionInterface.IsValid() || !SocketSubsystem
+			|| !Candidate.Session.SessionSettings.Get(SETTING_QOS_PORT, QosPort)
+			|| !OnlineSessionInterface->GetResolvedConnectString(Candidate, NAME_GamePort, ConnectString))
+		{
+			continue;
+		}
+
+		// Platform connect strings (e.g. steam.<id>) carry no IP address and cannot be probed directly
+		const TSharedPtr<FInternetAddr> Address = SocketSubsystem->GetAddressFromString(ConnectString.Left(ConnectString.Find(TEXT(":"), ESearchCase::IgnoreCase, ESearchDir::FromEnd)));
+		if (!Address.IsValid() || !Address->IsValid())
+		{
+			continue;
+		}
+
+		Address->SetPort(QosPort);
+		Targets.Add(Address.ToSharedRef());
+		QosProbedCandidateIndices.Add(CandidateIndex);
+	}
+
+	QosProbe = MakeUnique<FMultiplayerSessionsQosProbe>();
+	if (!QosProbe->Start(Targets, FOnMultiplayerQosProbeComplete::CreateUObject(this, &UMultiplayerSessionsSubsystem::OnQosProbeComplete)))
+	{
+		QosProbe.Reset();
+		OnMultiplayerSessionsRanked.Broadcast(QosCandidates);
+	}
+}
+
+void UMultiplayerSessionsSubsystem::OnQosProbeComplete(const TArray<FMultiplayerSessionQosResult>& Results)
+{
+	TArray<double> Scores;
+	Scores.Init(MAX_dbl, QosCandidates.Num());
+	for (int32 ProbeIndex = 0; ProbeIndex < Results.Num() && ProbeIndex < QosProbedCandidateIndices.Num(); ++ProbeIndex)
+	{
+		Scores[QosProbedCandidateIndices[ProbeIndex]] = Results[ProbeIndex].GetScore();
+	}
+
+	TArray<int32> Order;
+	for (int32 CandidateIndex = 0; CandidateIndex < QosCandidates.Num(); ++CandidateIndex)
+	{
+		Order.Add(CandidateIndex);
+	}
+
+	Order.StableSort([&Scores](const int32 A, const int32 B)
+	{
+		return Scores[A] < Scores[B];
+	});
+
+	TArray<FOnlineSessionSearchResult> RankedResults;
+	for (const int32 CandidateIndex : Order)
+	{
+		RankedResults.Add(QosCandidates[CandidateIndex]);
+	}
+
+	QosCandidates.Reset();
+	QosProbedCandidateIndices.Reset();
+
+	OnMultiplayerSessionsRanked.Broadcast(RankedResults);
+}
+
+bool UMultiplayerSessionsSubsystem::StartQosResponder()
+{
+	UWorld* World = GetWorld();
+	UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+	if (!NetDriver)
+	{
+		return false;
+	}
+
+	// Clients can only probe hosts whose connect string is an IP address, platform sockets (e.g. Steam P2P) never get probed
+	const TSharedPtr<const FInternetAddr> ListenAddress = NetDriver->GetLocalAddr();
+	const bool bListensOnIp = ListenAddress.IsValid()
+		&& (ListenAddress->GetProtocolType() == FNetworkProtocolTypes::IPv4 || ListenAddress->GetProtocolType() == FNetworkProtocolTypes::IPv6);
+	if (!bListensOnIp && !IsLanBackend())
+	{
+		return false;
+	}
+
+	if (!QosResponder)
+	{
+		QosResponder = MakeUnique<FMultiplayerSessionsQosResponder>();
+	}
+
+	if (QosResponder->IsRunning())
+	{
+		return true;
+	}
+
+	// The net driver may have moved off the URL port if it was taken, so prefer the port it really listens on
+	int32 GamePort = World->URL.Port;
+	if (bListensOnIp && ListenAddress->GetPort() > 0)
+	{
+		GamePort = ListenAddress->GetPort();
+	}
+
+	return QosResponder->Start(GamePort + MultiplayerSessionsQos::GamePortOffset, MultiplayerSessionsQos::MaxPortAttempts);
+}
+
+void UMultiplayerSessionsSubsystem::StopQosResponder()
+{
+	QosResponder.Reset();
+}
+
+bool UMultiplayerSessionsSubsystem::IsInParty() const
+{
+	return HasNamedSession(NAME_PartySession);
+}
+
+bool UMultiplayerSessionsSubsystem::IsPartyLeader() const
+{
+	if (!OnlineSessionInterface.IsValid())
+	{
+		return false;
+	}
+
+	const FNamedOnlineSession* PartySession = OnlineSessionInterface->GetNamedSession(NAME_PartySession);
+	return PartySession && PartySession->bHosting;
+}
+
+int32 UMultiplayerSessionsSubsystem::GetPartySize() const
+{
+	// Members never connect to the leader, so open connection counts say nothing about them; only join notifications do
+	return IsInParty() ? 1 + PartyMemberIds.Num() : 1;
+}
+
+bool UMultiplayerSessionsSubsystem::HasOpenSlots(const FOnlineSessionSearchResult& SessionSearchResult, const int32 RequiredSlots)
+{
+	const FOnlineSessionSettings& ResultSettings = SessionSearchResult.Session.SessionSettings;
+	if (!ResultSettings.bAllowJoinInProgress)
+	{
+		return false;
+	}
+
+	int32 PlayerCount = 0;
+	if (!ResultSettings.Get(SETTING_SESSION_PLAYER_COUNT, PlayerCount))
+	{
+		return SessionSearchResult.Session.NumOpenPublicConnections >= RequiredSlots;
+	}
+
+	return PlayerCount + RequiredSlots <= ResultSettings.NumPublicConnections;
+}
+
 UMultiplayerSessionsSubsystem* UMultiplayerSessionsSubsystem::Get(const UGameInstance* GameInstance)
 {
 	return GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
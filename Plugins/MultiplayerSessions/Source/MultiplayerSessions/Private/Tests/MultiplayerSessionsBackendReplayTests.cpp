@@ -0,0 +1,119 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MultiplayerSessionsSubsystem.h"
+
+#include "MultiplayerSessionsTestCommands.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "Interfaces/IPluginManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Paths.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace MultiplayerSessionsBackendReplayTests
+{
+	int32 CountCompletedEvents(const UMultiplayerSessionsSubsystem* Subsystem)
+	{
+		const FMultiplayerSessionsBackendRecorder* Recorder = Subsystem->GetBackendRecorder();
+		return Recorder ? Recorder->GetEvents().FilterByPredicate([](const FMultiplayerSessionsBackendEvent& Event) { return Event.HasCompleted(); }).Num() : 0;
+	}
+
+	void CheckRecreateOrder(FAutomationTestBase& Test, const TArray<FMultiplayerSessionsBackendEvent>& Events)
+	{
+		if (!Test.TestEqual(TEXT("Backend calls issued"), Events.Num(), 3))
+		{
+			return;
+		}
+
+		Test.TestTrue(TEXT("Calls are create, destroy, create"), Events[0].Operation == EMultiplayerSessionsBackendOp::Create
+			&& Events[1].Operation == EMultiplayerSessionsBackendOp::Destroy && Events[2].Operation == EMultiplayerSessionsBackendOp::Create);
+
+		for (const FMultiplayerSessionsBackendEvent& Event : Events)
+		{
+			Test.TestTrue(FString::Printf(TEXT("%s was accepted and succeeded"), LexToString(Event.Operation)), Event.bCallAccepted && Event.bWasSuccessful);
+		}
+
+		Test.TestTrue(TEXT("Destroy is issued after the first create completed"), Events[1].CallTime >= Events[0].CallTime + Events[0].Latency);
+		Test.TestTrue(TEXT("Destroy completes before the create is re-issued"), Events[2].CallTime >= Events[1].CallTime + Events[1].Latency);
+		Test.TestTrue(TEXT("Destroy completion waited for the recorded latency"), Events[1].Latency >= 0.25);
+	}
+
+	void DestroyGameInstance(UGameInstance* GameInstance)
+	{
+		UWorld* World = GameInstance->GetWorld();
+		GameInstance->Shutdown();
+		if (World)
+		{
+			GEngine->DestroyWorldContext(World);
+			World->DestroyWorld(false);
+		}
+
+		GameInstance->RemoveFromRoot();
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMultiplayerSessionsRecreateSessionReplayTest, "MultiplayerSessions.BackendReplay.RecreateSessionDestroysFirst",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMultiplayerSessionsRecreateSessionReplayTest::RunTest(const FString& Parameters)
+{
+	using namespace MultiplayerSessionsBackendReplayTests;
+
+	const TSharedPtr<IPlugin> Plugin = IPluginManager::Get().FindPlugin(TEXT("MultiplayerSessions"));
+	if (!TestTrue(TEXT("MultiplayerSessions plugin found"), Plugin.IsValid()))
+	{
+		return false;
+	}
+
+	const FString TracePath = FPaths::Combine(Plugin->GetBaseDir(), TEXT("Tests/SessionTraces/RecreateGameSession.json"));
+	const FString RecordingPath = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("RecreateGameSession.Replayed.json"));
+
+	UGameInstance* GameInstance = NewObject<UGameInstance>(GEngine);
+	GameInstance->AddToRoot();
+	GameInstance->InitializeStandalone();
+
+	UMultiplayerSessionsSubsystem* Subsystem = UMultiplayerSessionsSubsystem::Get(GameInstance);
+	if (!TestNotNull(TEXT("Subsystem"), Subsystem) || !TestTrue(TEXT("Trace loads"), Subsystem->StartBackendReplay(TracePath)))
+	{
+		DestroyGameInstance(GameInstance);
+		return false;
+	}
+
+	// Recording the replay captures the order in which the subsystem issued calls and received their completions
+	Subsystem->StartBackendRecording(RecordingPath);
+	Subsystem->RequestCreateSession(4, FString(TEXT("ReplayTest")));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FMultiplayerSessionsWaitUntilCommand(this, TEXT("the first create completes"), [Subsystem]()
+	{
+		return CountCompletedEvents(Subsystem) >= 1;
+	}));
+
+	// Hosting again while a game session exists has to destroy it first and only then re-issue the create
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([Subsystem]()
+	{
+		Subsystem->RequestCreateSession(4, FString(TEXT("ReplayTest")));
+		return true;
+	}));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FMultiplayerSessionsWaitUntilCommand(this, TEXT("the destroy and the re-issued create complete"), [Subsystem]()
+	{
+		return CountCompletedEvents(Subsystem) >= 3;
+	}));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, GameInstance, Subsystem]()
+	{
+		CheckRecreateOrder(*this, Subsystem->GetBackendRecorder()->GetEvents());
+
+		Subsystem->StopBackendRecording();
+		Subsystem->StopBackendReplay();
+		DestroyGameInstance(GameInstance);
+		return true;
+	}));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,173 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MultiplayerSessionsQos.h"
+
+#include "MultiplayerSessionsTestCommands.h"
+#include "IPAddress.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "Common/UdpSocketBuilder.h"
+#include "Interfaces/IPv4/IPv4Address.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace MultiplayerSessionsQosTests
+{
+	/** Sockets shared by every probe of the test, released by its last command */
+	struct FFixture
+	{
+		ISocketSubsystem* SocketSubsystem = nullptr;
+		FMultiplayerSessionsQosResponder Responder;
+		FSocket* SilentSocket = nullptr;
+
+		~FFixture()
+		{
+			if (SilentSocket)
+			{
+				SilentSocket->Close();
+				SocketSubsystem->DestroySocket(SilentSocket);
+			}
+		}
+	};
+
+	struct FProbeRun
+	{
+		int32 TargetCount = 0;
+		FMultiplayerSessionsQosProbe Probe;
+
+		bool bStarted = false;
+		bool bCompleted = false;
+		double StartTime = 0.0;
+		double CompletionTime = 0.0;
+		TArray<FMultiplayerSessionQosResult> Results;
+
+		/** Completion can only be noticed on a frame, so the longest frame seen while waiting is part of the allowance */
+		double LastFrameTime = 0.0;
+		double LongestFrameSeconds = 0.0;
+	};
+
+	TSharedRef<FInternetAddr> MakeLoopbackAddress(ISocketSubsystem& SocketSubsystem, const int32 Port)
+	{
+		const TSharedRef<FInternetAddr> Address = SocketSubsystem.CreateInternetAddr();
+		Address->SetLoopbackAddress();
+		Address->SetPort(Port);
+		return Address;
+	}
+
+	bool IsReachableTarget(const int32 TargetIndex)
+	{
+		// Every other target is unreachable, a single target is always reachable so the early exit is covered too
+		return TargetIndex % 2 == 0;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMultiplayerSessionsQosProbeDeadlineTest, "MultiplayerSessions.Qos.ProbeCompletesWithinOneDeadline",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMultiplayerSessionsQosProbeDeadlineTest::RunTest(const FString& Parameters)
+{
+	using namespace MultiplayerSessionsQosTests;
+
+	const TSharedRef<FFixture> Fixture = MakeShared<FFixture>();
+	Fixture->SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	if (!TestNotNull(TEXT("Socket subsystem"), Fixture->SocketSubsystem))
+	{
+		return false;
+	}
+
+	if (!TestTrue(TEXT("Responder binds a free port"), Fixture->Responder.Start(0)))
+	{
+		return false;
+	}
+
+	// Bound but never answering, so probes sent to it are lost without an ICMP error ending the wait early
+	Fixture->SilentSocket = FUdpSocketBuilder(TEXT("MultiplayerSessionsQosTestSilent"))
+		.AsNonBlocking()
+		.BoundToAddress(FIPv4Address::InternalLoopback)
+		.BoundToPort(0)
+		.Build();
+
+	if (!TestNotNull(TEXT("Silent socket"), Fixture->SilentSocket))
+	{
+		return false;
+	}
+
+	for (const int32 TargetCount : { 1, 4, 16, 64 })
+	{
+		const TSharedRef<FProbeRun> Run = MakeShared<FProbeRun>();
+		Run->TargetCount = TargetCount;
+
+		ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Fixture, Run]()
+		{
+			TArray<TSharedRef<FInternetAddr>> Targets;
+			for (int32 TargetIndex = 0; TargetIndex < Run->TargetCount; ++TargetIndex)
+			{
+				const int32 Port = IsReachableTarget(TargetIndex) ? Fixture->Responder.GetPort() : Fixture->SilentSocket->GetPortNo();
+				Targets.Add(MakeLoopbackAddress(*Fixture->SocketSubsystem, Port));
+			}
+
+			Run->StartTime = FPlatformTime::Seconds();
+			Run->LastFrameTime = Run->StartTime;
+
+			// The probe belongs to the run, so its callback must not keep the run alive
+			Run->bStarted = Run->Probe.Start(Targets, FOnMultiplayerQosProbeComplete::CreateLambda([WeakRun = TWeakPtr<FProbeRun>(Run)](const TArray<FMultiplayerSessionQosResult>& InResults)
+			{
+				if (const TSharedPtr<FProbeRun> PinnedRun = WeakRun.Pin())
+				{
+					PinnedRun->bCompleted = true;
+					PinnedRun->CompletionTime = FPlatformTime::Seconds();
+					PinnedRun->Results = InResults;
+				}
+			}));
+
+			TestTrue(FString::Printf(TEXT("Probe of %d targets starts"), Run->TargetCount), Run->bStarted);
+			return true;
+		}));
+
+		ADD_LATENT_AUTOMATION_COMMAND(FMultiplayerSessionsWaitUntilCommand(this, FString::Printf(TEXT("the probe of %d targets completes"), TargetCount), [Run]()
+		{
+			const double Now = FPlatformTime::Seconds();
+			Run->LongestFrameSeconds = FMath::Max(Run->LongestFrameSeconds, Now - Run->LastFrameTime);
+			Run->LastFrameTime = Now;
+
+			return !Run->bStarted || Run->bCompleted;
+		}, MultiplayerSessionsQos::DefaultDeadlineSeconds * 4.0));
+
+		ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Run]()
+		{
+			if (!Run->bCompleted)
+			{
+				return true;
+			}
+
+			const double ElapsedSeconds = Run->CompletionTime - Run->StartTime;
+			const double AllowedSeconds = MultiplayerSessionsQos::DefaultDeadlineSeconds + Run->LongestFrameSeconds;
+			TestTrue(FString::Printf(TEXT("Probe of %d targets took %.3f s, within one deadline plus one frame (%.3f s)"),
+				Run->TargetCount, ElapsedSeconds, AllowedSeconds), ElapsedSeconds <= AllowedSeconds);
+
+			if (TestEqual(TEXT("One result per target"), Run->Results.Num(), Run->TargetCount))
+			{
+				for (int32 TargetIndex = 0; TargetIndex < Run->TargetCount; ++TargetIndex)
+				{
+					TestEqual(FString::Printf(TEXT("Target %d of %d reached"), TargetIndex, Run->TargetCount),
+						Run->Results[TargetIndex].WasReached(), IsReachableTarget(TargetIndex));
+				}
+			}
+
+			return true;
+		}));
+	}
+
+	// The fixture lives until this last command lets go of it
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([Fixture]()
+	{
+		Fixture->Responder.Stop();
+		return true;
+	}));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
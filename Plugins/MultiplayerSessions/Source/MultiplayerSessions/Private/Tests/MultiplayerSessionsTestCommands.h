@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Checks the predicate once per frame, while the engine keeps ticking as usual, until it holds or the timeout passes.
+ * A timeout is reported as an error on the test and ends the wait so the commands queued after it still run.
+ */
+class FMultiplayerSessionsWaitUntilCommand : public IAutomationLatentCommand
+{
+private:
+	FAutomationTestBase* Test;
+	FString Description;
+	TFunction<bool()> Predicate;
+	double TimeoutSeconds;
+
+public:
+	FMultiplayerSessionsWaitUntilCommand(FAutomationTestBase* InTest, const FString& InDescription, TFunction<bool()>&& InPredicate, const double InTimeoutSeconds = 5.0)
+		: Test(InTest)
+		, Description(InDescription)
+		, Predicate(MoveTemp(InPredicate))
+		, TimeoutSeconds(InTimeoutSeconds)
+	{
+	}
+
+	virtual bool Update() override
+	{
+		if (Predicate())
+		{
+			return true;
+		}
+
+		if (GetCurrentRunTime() < TimeoutSeconds)
+		{
+			return false;
+		}
+
+		Test->AddError(FString::Printf(TEXT("Timed out after %.1f s waiting until %s"), TimeoutSeconds, *Description));
+		return true;
+	}
+};
+
+#endif // WITH_DEV_AUTOMATION_TESTS
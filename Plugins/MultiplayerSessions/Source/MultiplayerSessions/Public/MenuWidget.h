@@ -3,6 +3,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "MultiplayerSessionAttributes.h"
 #include "Blueprint/UserWidget.h"
 #include "Interfaces/OnlineSessionInterface.h"
 #include "UObject/Object.h"
@@ -23,13 +24,26 @@ private:
 	UPROPERTY(meta = (BindWidget))
 	UButton* JoinButton;
 
+	/** Creates a party others can join through platform invites, or leaves the current one */
+	UPROPERTY(meta = (BindWidgetOptional))
+	UButton* PartyButton;
+
 private:
 	UPROPERTY(Transient)
 	UMultiplayerSessionsSubsystem* MultiplayerSessionsSubsystem;
 
+private:
+	/** How many matching sessions are QoS probed before picking one to join */
+	UPROPERTY(EditDefaultsOnly, Category = "Sessions", meta = (ClampMin = "1"))
+	int32 MaxQosCandidates = 5;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Sessions", meta = (ClampMin = "2"))
+	int32 MaxPartySize = 4;
+
 private:
 	int32 MaxSessionSearches;
 	FString MatchType;
+	FMultiplayerSessionAttributes SessionAttributes;
 	FString PathToLobby;
 
 protected:
@@ -41,6 +55,7 @@ protected:
 	virtual void OnMultiplayerSessionCreated(const FName SessionName, const bool bWasSuccessful);
 
 	virtual void OnMultiplayerSessionsFound(const TArray<FOnlineSessionSearchResult>& SearchResults, const bool bWasSuccessful);
+	virtual void OnMultiplayerSessionsRanked(const TArray<FOnlineSessionSearchResult>& RankedResults);
 	virtual void OnMultiplayerSessionJoined(const EOnJoinSessionCompleteResult::Type Result);
 
 	UFUNCTION()
@@ -48,10 +63,14 @@ protected:
 
 	UFUNCTION()
 	virtual void OnMultiplayerSessionStarted(const FName SessionName, const bool bWasSuccessful);
+
+	virtual void OnMultiplayerPartyConnectTargetReceived(const FString& ConnectString);
 	
 public:
+	/** Map id, region, skill band and mode flags are advertised when hosting and filter results when joining, 0 means any */
 	UFUNCTION(BlueprintCallable, meta = (AutoCreateRefTerm="NewMatchType,PathToLobby"))
-	void SetupMenu(const int32 NewMaxSearchSessions = 10000, const FString& NewMatchType = TEXT("DefaultMatchType"), const FString& NewPathToLobby = TEXT("/Game/ThirdPerson/Maps/Lobby"));
+	void SetupMenu(const int32 NewMaxSearchSessions = 10000, const FString& NewMatchType = TEXT("DefaultMatchType"), const FString& NewPathToLobby = TEXT("/Game/ThirdPerson/Maps/Lobby"),
+		const int32 NewMapId = 0, const int32 NewRegion = 0, const int32 NewSkillBand = 0, const int32 NewModeFlags = 0);
 
 private:
 	void TearDownMenu();
@@ -63,6 +82,9 @@ private:
 	UFUNCTION()
 	void OnJoinButtonClicked();
 
+	UFUNCTION()
+	void OnPartyButtonClicked();
+
 	void EnableButtons();
 	void DisableButtons();
 };
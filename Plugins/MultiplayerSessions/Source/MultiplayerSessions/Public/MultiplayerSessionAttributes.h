@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FOnlineSessionSettings;
+
+/** Session settings key holding the packed FMultiplayerSessionAttributes value */
+#define SETTING_PACKED_SESSION_ATTRIBUTES FName(TEXT("PACKEDATTRS"))
+
+enum class EMultiplayerSessionModeFlags : uint8
+{
+	None			= 0,
+	Ranked			= 1 << 0,
+	Private			= 1 << 1,
+	FriendlyFire	= 1 << 2,
+	Spectators		= 1 << 3,
+};
+ENUM_CLASS_FLAGS(EMultiplayerSessionModeFlags);
+
+/**
+ * Advertised session metadata, packed into a single 64-bit setting so search and ping payloads stay small
+ * and clients match sessions with integer comparisons instead of string parsing.
+ *
+ * Layout (LSB first): Version:4 | MatchTypeId:16 | MapId:12 | Region:4 | BuildId:16 | SkillBand:4 | ModeFlags:8
+ */
+struct MULTIPLAYERSESSIONS_API FMultiplayerSessionAttributes
+{
+	static constexpr uint8 SchemaVersion = 1;
+
+	static constexpr uint16 MaxMapId = (1 << 12) - 1;
+	static constexpr uint8 MaxRegion = (1 << 4) - 1;
+	static constexpr uint8 MaxSkillBand = (1 << 4) - 1;
+
+	uint16 MatchTypeId = 0;
+	uint16 MapId = 0;
+	uint8 Region = 0;
+	uint16 BuildId = 0;
+	uint8 SkillBand = 0;
+	EMultiplayerSessionModeFlags ModeFlags = EMultiplayerSessionModeFlags::None;
+
+public:
+	FMultiplayerSessionAttributes() = default;
+	explicit FMultiplayerSessionAttributes(const FString& MatchType);
+
+	/** Stable 16-bit id for a match type name, identical on host and client */
+	static uint16 MakeMatchTypeId(const FString& MatchType);
+
+	/** 16-bit fold of the local network version, so only builds that can connect to each other match */
+	static uint16 GetLocalBuildId();
+
+	/** Out of range values are clamped to the width of their field */
+	void SetMapId(const int32 InMapId);
+	void SetRegion(const int32 InRegion);
+	void SetSkillBand(const int32 InSkillBand);
+	void SetModeFlags(const EMultiplayerSessionModeFlags InModeFlags);
+
+	int64 Pack() const;
+	static bool Unpack(const int64 PackedValue, FMultiplayerSessionAttributes& OutAttributes);
+
+	void WriteTo(FOnlineSessionSettings& SessionSettings) const;
+	static bool ReadFrom(const FOnlineSessionSettings& SessionSettings, FMultiplayerSessionAttributes& OutAttributes);
+
+	/**
+	 * Whether a client looking for these attributes can join a session advertising Other. Match type and build
+	 * must be equal, a zero map, region or skill band means any, and Other must have every mode flag set here.
+	 */
+	bool IsCompatibleWith(const FMultiplayerSessionAttributes& Other) const;
+
+	FORCEINLINE bool HasModeFlags(const EMultiplayerSessionModeFlags Flags) const { return EnumHasAllFlags(ModeFlags, Flags); }
+
+	bool operator==(const FMultiplayerSessionAttributes& Other) const { return Pack() == Other.Pack(); }
+	bool operator!=(const FMultiplayerSessionAttributes& Other) const { return !(*this == Other); }
+};
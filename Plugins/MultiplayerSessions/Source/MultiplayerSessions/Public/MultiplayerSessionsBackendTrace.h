@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+
+enum class EMultiplayerSessionsBackendOp : uint8
+{
+	Create,
+	Destroy,
+	Find,
+	Join,
+	Update,
+};
+
+MULTIPLAYERSESSIONS_API const TCHAR* LexToString(const EMultiplayerSessionsBackendOp Operation);
+MULTIPLAYERSESSIONS_API bool LexTryParseString(EMultiplayerSessionsBackendOp& OutOperation, const TCHAR* String);
+
+/** One backend call and its completion, times are in seconds relative to the start of the trace */
+struct MULTIPLAYERSESSIONS_API FMultiplayerSessionsBackendEvent
+{
+	EMultiplayerSessionsBackendOp Operation = EMultiplayerSessionsBackendOp::Create;
+	FName SessionName;
+	FString Arguments;
+
+	double CallTime = 0.0;
+	bool bCallAccepted = false;
+
+	/** Negative while the completion has not arrived */
+	double Latency = -1.0;
+	bool bWasSuccessful = false;
+	int32 ResultCode = 0;
+	int32 ResultSize = 0;
+
+	FORCEINLINE bool HasCompleted() const { return Latency >= 0.0; }
+};
+
+/** Captures every backend call and completion so a session flow can be replayed without the real backend */
+class MULTIPLAYERSESSIONS_API FMultiplayerSessionsBackendRecorder
+{
+private:
+	double StartTime = 0.0;
+	TArray<FMultiplayerSessionsBackendEvent> Events;
+	TMap<TPair<EMultiplayerSessionsBackendOp, FName>, TArray<int32>> PendingEventIndices;
+
+public:
+	FMultiplayerSessionsBackendRecorder();
+
+	/** Call before issuing the request, backends may complete synchronously from inside the call */
+	int32 RecordCall(const EMultiplayerSessionsBackendOp Operation, const FName SessionName, const FString& Arguments);
+	void RecordCallRejected(const int32 EventIndex);
+	void RecordCompletion(const EMultiplayerSessionsBackendOp Operation, const FName SessionName, const bool bWasSuccessful, const int32 ResultCode = 0, const int32 ResultSize = 0);
+
+	bool SaveToFile(const FString& FilePath) const;
+
+	FORCEINLINE const TArray<FMultiplayerSessionsBackendEvent>& GetEvents() const { return Events; }
+};
+
+/**
+ * Local stand-in for the session backend. Each call consumes the next recorded event for the same operation
+ * and session, and its completion is delivered after the recorded latency so callback ordering matches the capture.
+ */
+class MULTIPLAYERSESSIONS_API FMultiplayerSessionsBackendReplay
+{
+public:
+	using FOnReplayedCompletion = TFunction<void(const FMultiplayerSessionsBackendEvent&)>;
+
+private:
+	TMap<TPair<EMultiplayerSessionsBackendOp, FName>, TArray<FMultiplayerSessionsBackendEvent>> QueuedEvents;
+	TSet<FName> ActiveSessions;
+
+	/** Completions still waiting out their recorded latency, dropped with the replay so they never reach a later one */
+	TArray<FTSTicker::FDelegateHandle> CompletionTickerHandles;
+
+public:
+	~FMultiplayerSessionsBackendReplay();
+
+	bool LoadFromFile(const FString& FilePath);
+
+	/** Returns whether the recorded call was accepted; if so OnCompletion fires after the recorded latency */
+	bool Call(const EMultiplayerSessionsBackendOp Operation, const FName SessionName, FOnReplayedCompletion&& OnCompletion);
+
+	/** Keeps the stand-in's view of which named sessions exist in step with replayed completions */
+	void ApplyCompletion(const FMultiplayerSessionsBackendEvent& Event);
+
+	FORCEINLINE bool HasSession(const FName SessionName) const { return ActiveSessions.Contains(SessionName); }
+};
@@ -0,0 +1,97 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Serialization/ArrayReader.h"
+
+class FInternetAddr;
+class FSocket;
+class FUdpSocketReceiver;
+struct FIPv4Endpoint;
+
+/** Session settings key holding the UDP port of the host's QoS responder */
+#define SETTING_QOS_PORT FName(TEXT("QOSPORT"))
+
+struct MULTIPLAYERSESSIONS_API FMultiplayerSessionQosResult
+{
+	int32 PacketsSent = 0;
+	int32 PacketsReceived = 0;
+	double TotalRttMs = 0.0;
+
+	bool WasReached() const { return PacketsReceived > 0; }
+	double GetAverageRttMs() const;
+	double GetLossRatio() const;
+
+	/** Lower is better, unreached hosts score MAX_dbl */
+	double GetScore() const;
+};
+
+DECLARE_DELEGATE_OneParam(FOnMultiplayerQosProbeComplete, const TArray<FMultiplayerSessionQosResult>& Results);
+
+namespace MultiplayerSessionsQos
+{
+	/** The responder binds next to the game net driver, at its listen port plus this offset */
+	constexpr int32 GamePortOffset = 10;
+	/** Consecutive ports tried after that, so several hosts on one machine each get their own */
+	constexpr int32 MaxPortAttempts = 10;
+	constexpr int32 DefaultPacketsPerTarget = 3;
+	constexpr float DefaultDeadlineSeconds = 0.5f;
+}
+
+/** Host side: echoes QoS probe packets back to the sender from a dedicated receive thread */
+class MULTIPLAYERSESSIONS_API FMultiplayerSessionsQosResponder
+{
+private:
+	FSocket* Socket = nullptr;
+	TUniquePtr<FUdpSocketReceiver> Receiver;
+	int32 BoundPort = 0;
+
+public:
+	~FMultiplayerSessionsQosResponder();
+
+	/** Binds the first free port from FirstPort on, port 0 picks any free port. GetPort() reports the one bound */
+	bool Start(const int32 FirstPort, const int32 MaxPortAttempts = 1);
+	void Stop();
+
+	FORCEINLINE bool IsRunning() const { return Socket != nullptr; }
+	FORCEINLINE int32 GetPort() const { return BoundPort; }
+
+private:
+	void OnDataReceived(const FArrayReaderPtr& Data, const FIPv4Endpoint& Sender);
+};
+
+/**
+ * Client side: probes every target in parallel from a single socket and reports once all replies are in
+ * or the deadline passes, so the total wait is bounded by one deadline regardless of the target count.
+ */
+class MULTIPLAYERSESSIONS_API FMultiplayerSessionsQosProbe
+{
+private:
+	FSocket* Socket = nullptr;
+	FTSTicker::FDelegateHandle TickerHandle;
+	FOnMultiplayerQosProbeComplete OnComplete;
+
+	TArray<FMultiplayerSessionQosResult> Results;
+	TArray<uint32> ReceivedSequenceMasks;
+	int32 PacketsPerTarget = 0;
+	int32 OutstandingPackets = 0;
+	double DeadlineTime = 0.0;
+
+public:
+	~FMultiplayerSessionsQosProbe();
+
+	bool Start(const TArray<TSharedRef<FInternetAddr>>& Targets, FOnMultiplayerQosProbeComplete&& InOnComplete,
+		const int32 InPacketsPerTarget = MultiplayerSessionsQos::DefaultPacketsPerTarget,
+		const float DeadlineSeconds = MultiplayerSessionsQos::DefaultDeadlineSeconds);
+	void Cancel();
+
+	FORCEINLINE bool IsRunning() const { return Socket != nullptr; }
+
+private:
+	bool Tick(float DeltaTime);
+	void ReceivePendingReplies();
+	void Finish();
+	void CloseSocket();
+};
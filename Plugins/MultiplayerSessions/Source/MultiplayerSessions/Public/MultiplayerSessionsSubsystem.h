@@ -3,18 +3,40 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "MultiplayerSessionAttributes.h"
+#include "MultiplayerSessionsBackendTrace.h"
+#include "MultiplayerSessionsQos.h"
 #include "OnlineSessionSettings.h"
 #include "OnlineSubsystem.h"
 #include "Interfaces/OnlineSessionInterface.h"
 #include "Subsystems/GameInstanceSubsystem.h"
 #include "MultiplayerSessionsSubsystem.generated.h"
 
+/** Session settings key holding the live player count published by the host */
+#define SETTING_SESSION_PLAYER_COUNT FName(TEXT("PLAYERCOUNT"))
+
+/** Party session settings key holding the connect string the party leader wants members to follow */
+#define SETTING_PARTY_CONNECT_TARGET FName(TEXT("PARTYTARGET"))
+
+/** Marks a session as a party so accepted invites are joined under the right session name */
+#define SETTING_PARTY_SESSION FName(TEXT("PARTYSESSION"))
+
+/** Travel URL options naming the party a player arrives with and its size, so the host can hold slots for all of it */
+#define PARTY_OPTION_ID TEXT("PartyId")
+#define PARTY_OPTION_SIZE TEXT("PartySize")
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnMultiplayerSessionCreated, const FName, SessionName, const bool, bWasSuccessful);
 DECLARE_MULTICAST_DELEGATE_TwoParams(FOnMultiplayerFindSessionsComplete, const TArray<FOnlineSessionSearchResult>& SearchResults, const bool bWasSuccessful);
 DECLARE_MULTICAST_DELEGATE_OneParam(FOnMultiplayerJoinSessionComplete, const EOnJoinSessionCompleteResult::Type Result);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnMultiplayerSessionDestroyed, const bool, bWassuccessful);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnMultiplayerStartSessionComplete, const FName, SessionName, const bool, bWassuccessful);
 
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnMultiplayerPartySessionCreated, const bool bWasSuccessful);
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnMultiplayerPartySessionJoined, const EOnJoinSessionCompleteResult::Type Result);
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnMultiplayerPartyConnectTargetReceived, const FString& ConnectString);
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnMultiplayerSessionsRanked, const TArray<FOnlineSessionSearchResult>& RankedResults);
+
 UCLASS()
 class MULTIPLAYERSESSIONS_API UMultiplayerSessionsSubsystem : public UGameInstanceSubsystem
 {
@@ -24,12 +46,29 @@ private:
 	IOnlineSessionPtr OnlineSessionInterface;
 	
 	FOnlineSessionSettings SessionSettings;
+	FMultiplayerSessionAttributes SessionAttributes;
 	TSharedPtr<FOnlineSessionSearch> SessionSearchResults;
 
+	FOnlineSessionSettings PartySessionSettings;
+	FString LastPartyConnectTarget;
+	TArray<FUniqueNetIdRef> PartyMemberIds;
+
+	TUniquePtr<FMultiplayerSessionsQosResponder> QosResponder;
+	TUniquePtr<FMultiplayerSessionsQosProbe> QosProbe;
+	TArray<FOnlineSessionSearchResult> QosCandidates;
+	TArray<int32> QosProbedCandidateIndices;
+
+	TUniquePtr<FMultiplayerSessionsBackendRecorder> BackendRecorder;
+	FString BackendRecordingPath;
+	TUniquePtr<FMultiplayerSessionsBackendReplay> BackendReplay;
+
+	/** Set right before a locally reported failure, whose completion has no backend call to match in the recording */
+	bool bNextCompletionIsSynthetic = false;
+
 private:
 	bool bCreateSessionOnDestroy = false;
 	int32 LastCreateRequestPublicConnections;
-	FString LastCreateRequestMatchType;
+	FMultiplayerSessionAttributes LastCreateRequestAttributes;
 
 public:
 	FOnMultiplayerSessionCreated OnMultiplayerSessionCreatedDelegate;
@@ -39,18 +78,43 @@ public:
 	FOnMultiplayerSessionDestroyed OnMultiplayerSessionDestroyed;
 
 	FOnMultiplayerStartSessionComplete OnMultiplayerSessionStarted;
+
+	FOnMultiplayerPartySessionCreated OnMultiplayerPartySessionCreated;
+	FOnMultiplayerPartySessionJoined OnMultiplayerPartySessionJoined;
+	FOnMultiplayerPartyConnectTargetReceived OnMultiplayerPartyConnectTargetReceived;
+
+	FOnMultiplayerSessionsRanked OnMultiplayerSessionsRanked;
 	
 public:
 	UMultiplayerSessionsSubsystem();
 	
 protected:
 	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
 
 private:
 	void BindDelegates();
 
+	/** Every backend request goes through these so it can be recorded, or served from a replayed trace */
+	bool BackendCreateSession(const FUniqueNetIdPtr& HostingPlayerId, const FName SessionName, const FOnlineSessionSettings& NewSessionSettings);
+	bool BackendDestroySession(const FName SessionName);
+	bool BackendFindSessions(const FUniqueNetIdPtr& SearchingPlayerId, const TSharedRef<FOnlineSessionSearch>& SearchSettings);
+	bool BackendJoinSession(const FUniqueNetIdPtr& PlayerId, const FName SessionName, const FOnlineSessionSearchResult& DesiredSession);
+	bool BackendUpdateSession(const FName SessionName, FOnlineSessionSettings& UpdatedSessionSettings);
+	bool HasNamedSession(const FName SessionName) const;
+
+	/** True when requests can be served, either by the online backend or by a replayed trace */
+	bool HasSessionBackend() const;
+	bool IsLanBackend() const;
+	FUniqueNetIdPtr GetLocalPlayerId() const;
+
+	bool ReplayBackendCall(const EMultiplayerSessionsBackendOp Operation, const FName SessionName);
+	void DispatchReplayedCompletion(const FMultiplayerSessionsBackendEvent& Event);
+	void RecordBackendCompletion(const EMultiplayerSessionsBackendOp Operation, const FName SessionName, const bool bWasSuccessful, const int32 ResultCode = 0, const int32 ResultSize = 0);
+
 public:
 	void RequestCreateSession(const int32 NumPublicConnections, const FString& MatchType);
+	void RequestCreateSession(const int32 NumPublicConnections, const FMultiplayerSessionAttributes& Attributes);
 	void OnCreateSessionComplete(const FName SessionName, const bool bWasSuccessful);
 	
 	void DestroySession();
@@ -65,9 +129,77 @@ public:
 	void StartSession();
 	void OnStartSessionComplete(const FName SessionName, const bool bWasSuccessful);
 
+	void UpdateSessionPlayerCount(const int32 PlayerCount);
+	void OnUpdateSessionComplete(const FName SessionName, const bool bWasSuccessful);
+
+	/** Other players join the party by accepting a platform invite, see OnSessionUserInviteAccepted */
+	UFUNCTION(BlueprintCallable)
+	void CreatePartySession(const int32 MaxPartySize = 4);
+
+	void JoinPartySession(const FOnlineSessionSearchResult& PartySearchResult);
+
+	UFUNCTION(BlueprintCallable)
+	void DestroyPartySession();
+
+	/** Identifies the party to hosts, empty when not in one */
+	FString GetPartyId() const;
+
+	/** Appended to the connect string when travelling to a game session, empty when not in a party */
+	FString GetPartyTravelOptions() const;
+
+	/** Leader only: tells every party member where to travel, so they never search for the game session themselves */
+	void PublishPartyConnectTarget(const FString& ConnectString);
+
+	/**
+	 * Called by the hosting game mode once its world accepts connections. Starts and advertises the QoS responder
+	 * next to the game port when the game listens on IP, and only then sends party members here.
+	 */
+	void NotifyListenServerReady();
+
+	void OnSessionSettingsUpdated(const FName SessionName, const FOnlineSessionSettings& UpdatedSettings);
+	void OnSessionUserInviteAccepted(const bool bWasSuccessful, const int32 ControllerId, FUniqueNetIdPtr UserId, const FOnlineSessionSearchResult& InviteResult);
+	void OnSessionParticipantJoined(const FName SessionName, const FUniqueNetId& UniqueId);
+	void OnSessionParticipantLeft(const FName SessionName, const FUniqueNetId& UniqueId, EOnSessionParticipantLeftReason LeaveReason);
+
+	void StartBackendRecording(const FString& FilePath);
+	void StopBackendRecording();
+
+	/** Serves all session requests from a recorded trace instead of the online backend */
+	bool StartBackendReplay(const FString& FilePath);
+	void StopBackendReplay();
+
+	/** Probes the candidates' QoS responders in parallel and broadcasts them best first through OnMultiplayerSessionsRanked */
+	void RankSessionsByQos(const TArray<FOnlineSessionSearchResult>& Candidates);
+
+private:
+	void HandlePartyCreateSessionComplete(const bool bWasSuccessful);
+	void HandlePartyJoinSessionComplete(const EOnJoinSessionCompleteResult::Type Result);
+	void HandlePartyConnectTarget(const FOnlineSessionSettings& PartySettings);
+	void PublishGameSessionToParty();
+	bool IsLocalPlayerId(const FUniqueNetId& UniqueId) const;
+
+	bool StartQosResponder();
+	void StopQosResponder();
+	void OnQosProbeComplete(const TArray<FMultiplayerSessionQosResult>& Results);
+
 public:
 	UFUNCTION(BlueprintPure)
 	static UMultiplayerSessionsSubsystem* Get(const UGameInstance* GameInstance);
 
 	FORCEINLINE IOnlineSessionPtr GetOnlineSubsystemInterface() const { return OnlineSessionInterface; }
+	FORCEINLINE const FMultiplayerSessionAttributes& GetSessionAttributes() const { return SessionAttributes; }
+	FORCEINLINE int32 GetSessionMaxPlayers() const { return SessionSettings.NumPublicConnections; }
+	FORCEINLINE const FMultiplayerSessionsBackendRecorder* GetBackendRecorder() const { return BackendRecorder.Get(); }
+
+	UFUNCTION(BlueprintPure)
+	bool IsInParty() const;
+
+	UFUNCTION(BlueprintPure)
+	bool IsPartyLeader() const;
+
+	/** Local player plus every other member the party session has reported joining */
+	UFUNCTION(BlueprintPure)
+	int32 GetPartySize() const;
+
+	static bool HasOpenSlots(const FOnlineSessionSearchResult& SessionSearchResult, const int32 RequiredSlots = 1);
 };
@@ -3,14 +3,114 @@
 
 #include "LobbyGameMode.h"
 
+#include "MultiplayerPlugin.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "Engine/NetDriver.h"
 #include "GameFramework/GameStateBase.h"
 #include "GameFramework/PlayerState.h"
+#include "GameFramework/WorldSettings.h"
+#include "Kismet/GameplayStatics.h"
 
+namespace LobbyTickPolicy
+{
+	/** Process CPU usage is sampled over an interval, so frames this soon after a rate change would mix both rates */
+	constexpr double RateSettleSeconds = 0.5;
+}
+
+ALobbyGameMode::ALobbyGameMode()
+{
+	PrimaryActorTick.bCanEverTick = true;
+}
+
+void ALobbyGameMode::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// The lobby is already listening by now, so party members sent here can actually connect
+	if (GetNetMode() == NM_ListenServer || GetNetMode() == NM_DedicatedServer)
+	{
+		if (UMultiplayerSessionsSubsystem* MultiplayerSessionsSubsystem = UMultiplayerSessionsSubsystem::Get(GetGameInstance()))
+		{
+			// A hosting party leader is already here and sized the session for its party, the rest only needs holding
+			const FString PartyId = MultiplayerSessionsSubsystem->GetPartyId();
+			if (GetNetMode() == NM_ListenServer && !PartyId.IsEmpty())
+			{
+				AddPartyReservation(PartyId, MultiplayerSessionsSubsystem->GetPartySize());
+			}
+
+			MultiplayerSessionsSubsystem->NotifyListenServerReady();
+		}
+	}
+}
+
+void ALobbyGameMode::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// The net driver outlives the lobby across server travel, so the next map must not inherit the throttled rate
+	RestoreTickRate();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ALobbyGameMode::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (!UsesTickPolicy())
+	{
+		return;
+	}
+
+	AccumulateTickStats(DeltaSeconds);
+
+	if (IsAnyPlayerMoving())
+	{
+		LastActivityTime = GetWorld()->GetTimeSeconds();
+	}
+
+	UpdateTickRate();
+}
+
+void ALobbyGameMode::PreLogin(const FString& Options, const FString& Address, const FUniqueNetIdRepl& UniqueId, FString& ErrorMessage)
+{
+	Super::PreLogin(Options, Address, UniqueId, ErrorMessage);
+
+	if (!ErrorMessage.IsEmpty())
+	{
+		return;
+	}
+
+	RemoveExpiredPartyReservations();
+
+	const FString PartyId = UGameplayStatics::ParseOption(Options, PARTY_OPTION_ID);
+	if (!PartyId.IsEmpty())
+	{
+		if (!ReservePartySlots(PartyId, UGameplayStatics::GetIntOption(Options, PARTY_OPTION_SIZE, 1)))
+		{
+			ErrorMessage = TEXT("Not enough room for the whole party");
+		}
+
+		return;
+	}
+
+	// Players on their own cannot take slots held for party members still on their way
+	const int32 PlayerCount = GameState ? GameState->PlayerArray.Num() : 0;
+	if (IsSessionFull(PlayerCount + GetOpenReservedSlots()))
+	{
+		ErrorMessage = TEXT("Server full");
+	}
+}
 
 void ALobbyGameMode::PostLogin(APlayerController* NewPlayer)
 {
 	Super::PostLogin(NewPlayer);
 
+	// A new arrival should never wait for the idle rate to notice it
+	LastActivityTime = GetWorld()->GetTimeSeconds();
+	if (UsesTickPolicy())
+	{
+		UpdateTickRate();
+	}
+
 	if (GameState)
 	{
 		const int32 PlayerCount = GameState->PlayerArray.Num();
@@ -21,6 +121,8 @@ void ALobbyGameMode::PostLogin(APlayerController* NewPlayer)
 			const FString PlayerName = PlayerState->GetPlayerName();
 			GEngine->AddOnScreenDebugMessage(INDEX_NONE, 60.f, FColor::Cyan, FString::Printf(TEXT("%s has joined the game!"), *PlayerName));
 		}
+
+		OnPlayerCountChanged(PlayerCount);
 	}
 }
 
@@ -36,7 +138,263 @@ void ALobbyGameMode::Logout(AController* Exiting)
 			const FString PlayerName = PlayerState->GetPlayerName();
 			GEngine->AddOnScreenDebugMessage(INDEX_NONE, 60.f, FColor::Cyan, FString::Printf(TEXT("%s has exited the game!"), *PlayerName));
 		}
+
+		OnPlayerCountChanged(PlayerCount - 1);
 	}
 	
 	Super::Logout(Exiting);
 }
+
+void ALobbyGameMode::OnPlayerCountChanged(const int32 PlayerCount)
+{
+	PendingPlayerCount = PlayerCount;
+
+	// Crossing the full/not-full boundary changes whether clients can join, so it skips the rate limit
+	if (PublishedPlayerCount == INDEX_NONE || IsSessionFull(PendingPlayerCount) != IsSessionFull(PublishedPlayerCount))
+	{
+		PublishPlayerCount();
+		return;
+	}
+
+	FTimerManager& TimerManager = GetWorldTimerManager();
+	if (!TimerManager.IsTimerActive(SessionHeartbeatTimerHandle))
+	{
+		// The rate limit is kept in real time so time dilation cannot stretch or shrink it, while the timer runs in world time
+		const double TimeSinceLastPublish = GetWorld()->GetRealTimeSeconds() - LastPublishTime;
+		const float RealDelay = FMath::Max(SessionHeartbeatInterval - static_cast<float>(TimeSinceLastPublish), KINDA_SMALL_NUMBER);
+		const float TimeDilation = GetWorldSettings() ? GetWorldSettings()->GetEffectiveTimeDilation() : 1.f;
+		TimerManager.SetTimer(SessionHeartbeatTimerHandle, this, &ALobbyGameMode::PublishPlayerCount, FMath::Max(RealDelay * TimeDilation, KINDA_SMALL_NUMBER));
+	}
+}
+
+void ALobbyGameMode::PublishPlayerCount()
+{
+	GetWorldTimerManager().ClearTimer(SessionHeartbeatTimerHandle);
+
+	if (PendingPlayerCount == PublishedPlayerCount)
+	{
+		return;
+	}
+
+	if (UMultiplayerSessionsSubsystem* MultiplayerSessionsSubsystem = UMultiplayerSessionsSubsystem::Get(GetGameInstance()))
+	{
+		MultiplayerSessionsSubsystem->UpdateSessionPlayerCount(PendingPlayerCount);
+	}
+
+	PublishedPlayerCount = PendingPlayerCount;
+	LastPublishTime = GetWorld()->GetRealTimeSeconds();
+}
+
+bool ALobbyGameMode::IsSessionFull(const int32 PlayerCount) const
+{
+	const UMultiplayerSessionsSubsystem* MultiplayerSessionsSubsystem = UMultiplayerSessionsSubsystem::Get(GetGameInstance());
+	if (!MultiplayerSessionsSubsystem || MultiplayerSessionsSubsystem->GetSessionMaxPlayers() <= 0)
+	{
+		return false;
+	}
+
+	return PlayerCount >= MultiplayerSessionsSubsystem->GetSessionMaxPlayers();
+}
+
+bool ALobbyGameMode::ReservePartySlots(const FString& PartyId, const int32 PartySize)
+{
+	const double Now = GetWorld()->GetRealTimeSeconds();
+
+	// Later members take one of the slots their party already holds
+	if (FPartyReservation* Reservation = PartyReservations.Find(PartyId))
+	{
+		++Reservation->ArrivedPlayers;
+		Reservation->ExpireTime = Now + PartyReservationTimeout;
+
+		if (Reservation->GetOpenSlots() <= 0)
+		{
+			PartyReservations.Remove(PartyId);
+		}
+
+		return true;
+	}
+
+	// The first member to arrive reserves for everyone, including itself, or the party is turned away as a whole
+	const int32 PlayerCount = GameState ? GameState->PlayerArray.Num() : 0;
+	if (IsSessionFull(PlayerCount + GetOpenReservedSlots() + FMath::Max(PartySize, 1) - 1))
+	{
+		return false;
+	}
+
+	AddPartyReservation(PartyId, PartySize);
+	return true;
+}
+
+void ALobbyGameMode::AddPartyReservation(const FString& PartyId, const int32 PartySize)
+{
+	if (PartySize <= 1)
+	{
+		return;
+	}
+
+	FPartyReservation& Reservation = PartyReservations.Add(PartyId);
+	Reservation.ReservedSlots = PartySize;
+	Reservation.ArrivedPlayers = 1;
+	Reservation.ExpireTime = GetWorld()->GetRealTimeSeconds() + PartyReservationTimeout;
+}
+
+int32 ALobbyGameMode::GetOpenReservedSlots() const
+{
+	int32 OpenSlots = 0;
+	for (const TPair<FString, FPartyReservation>& Reservation : PartyReservations)
+	{
+		OpenSlots += Reservation.Value.GetOpenSlots();
+	}
+
+	return OpenSlots;
+}
+
+void ALobbyGameMode::RemoveExpiredPartyReservations()
+{
+	const double Now = GetWorld()->GetRealTimeSeconds();
+	for (auto ReservationIt = PartyReservations.CreateIterator(); ReservationIt; ++ReservationIt)
+	{
+		if (ReservationIt.Value().ExpireTime <= Now)
+		{
+			UE_LOG(LogMultiplayerPlugin, Log, TEXT("Releasing %d slots held for party %s"), ReservationIt.Value().GetOpenSlots(), *ReservationIt.Key());
+			ReservationIt.RemoveCurrent();
+		}
+	}
+}
+
+bool ALobbyGameMode::UsesTickPolicy() const
+{
+	// Listen servers render for the hosting player, so only dedicated lobby servers are throttled
+	return GetNetMode() == NM_DedicatedServer;
+}
+
+bool ALobbyGameMode::IsAnyPlayerMoving() const
+{
+	if (!GameState)
+	{
+		return false;
+	}
+
+	for (const APlayerState* PlayerState : GameState->PlayerArray)
+	{
+		const APawn* Pawn = PlayerState ? PlayerState->GetPawn() : nullptr;
+		if (Pawn && !Pawn->GetVelocity().IsNearlyZero())
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void ALobbyGameMode::UpdateTickRate()
+{
+	const int32 PlayerCount = GameState ? GameState->PlayerArray.Num() : 0;
+	const bool bIsActive = PlayerCount > 0 && GetWorld()->GetTimeSeconds() - LastActivityTime < IdleGraceSeconds;
+	bIsLobbyIdle = !bIsActive;
+
+	if (bIsActive)
+	{
+		CalibrationEndTime = 0.0;
+		ApplyTickRate(ActiveTickRate);
+		return;
+	}
+
+	// Now and then the idle lobby runs unthrottled, so the saving is measured against the same idle load and not a busy one
+	const double Now = GetWorld()->GetRealTimeSeconds();
+	if (Now >= NextCalibrationTime)
+	{
+		CalibrationEndTime = Now + TickCalibrationSeconds;
+		NextCalibrationTime = CalibrationEndTime + TickStatsLogInterval;
+	}
+
+	ApplyTickRate(Now < CalibrationEndTime ? ActiveTickRate : IdleTickRate);
+}
+
+void ALobbyGameMode::ApplyTickRate(const int32 TickRate)
+{
+	if (TickRate == AppliedTickRate)
+	{
+		return;
+	}
+
+	// A dedicated server's frame rate and net rate are both driven by the net driver's max tick rate
+	if (UNetDriver* NetDriver = GetWorld()->GetNetDriver())
+	{
+		if (OriginalTickRate == INDEX_NONE)
+		{
+			OriginalTickRate = NetDriver->GetNetServerMaxTickRate();
+		}
+
+		NetDriver->SetNetServerMaxTickRate(TickRate);
+		AppliedTickRate = TickRate;
+		LastTickRateChangeTime = GetWorld()->GetRealTimeSeconds();
+	}
+}
+
+void ALobbyGameMode::RestoreTickRate()
+{
+	if (OriginalTickRate == INDEX_NONE)
+	{
+		return;
+	}
+
+	if (UNetDriver* NetDriver = GetWorld() ? GetWorld()->GetNetDriver() : nullptr)
+	{
+		NetDriver->SetNetServerMaxTickRate(OriginalTickRate);
+	}
+
+	OriginalTickRate = INDEX_NONE;
+	AppliedTickRate = 0;
+}
+
+void ALobbyGameMode::AccumulateTickStats(const float DeltaSeconds)
+{
+	if (bIsLobbyIdle)
+	{
+		LobbyIdleSeconds += DeltaSeconds;
+	}
+	else
+	{
+		LobbyActiveSeconds += DeltaSeconds;
+	}
+
+	// Only idle frames are costed, at whichever rate governed them, so both samples carry the same gameplay load
+	if (bIsLobbyIdle && GetWorld()->GetRealTimeSeconds() - LastTickRateChangeTime >= LobbyTickPolicy::RateSettleSeconds)
+	{
+		const double CoresUsed = FPlatformTime::GetCPUTime().CPUTimePctRelative / 100.0;
+		if (AppliedTickRate == IdleTickRate)
+		{
+			IdleRateWallSeconds += DeltaSeconds;
+			IdleRateCoreSeconds += CoresUsed * DeltaSeconds;
+		}
+		else if (AppliedTickRate == ActiveTickRate)
+		{
+			ActiveRateWallSeconds += DeltaSeconds;
+			ActiveRateCoreSeconds += CoresUsed * DeltaSeconds;
+		}
+	}
+
+	TickStatsSecondsSinceLog += DeltaSeconds;
+	if (TickStatsSecondsSinceLog < TickStatsLogInterval)
+	{
+		return;
+	}
+
+	TickStatsSecondsSinceLog = 0.0;
+
+	if (IdleRateWallSeconds <= 0.0 || ActiveRateWallSeconds <= 0.0)
+	{
+		UE_LOG(LogMultiplayerPlugin, Log, TEXT("Lobby tick policy: idle lobby measured for %.0f s at %d Hz and %.0f s at %d Hz, not enough to compare yet"),
+			IdleRateWallSeconds, IdleTickRate, ActiveRateWallSeconds, ActiveTickRate);
+		return;
+	}
+
+	const double IdleRateCoreUsage = IdleRateCoreSeconds / IdleRateWallSeconds;
+	const double ActiveRateCoreUsage = ActiveRateCoreSeconds / ActiveRateWallSeconds;
+	const double IdleFraction = LobbyIdleSeconds / (LobbyIdleSeconds + LobbyActiveSeconds);
+	const double CoresSavedPer100Lobbies = 100.0 * (ActiveRateCoreUsage - IdleRateCoreUsage) * IdleFraction;
+
+	UE_LOG(LogMultiplayerPlugin, Log, TEXT("Lobby tick policy: idle lobby at %d Hz %.1f%% of a core, at %d Hz %.1f%% of a core, idle %.0f%% of the time, %.2f cores saved per 100 lobbies"),
+		IdleTickRate, IdleRateCoreUsage * 100.0, ActiveTickRate, ActiveRateCoreUsage * 100.0, IdleFraction * 100.0, CoresSavedPer100Lobbies);
+}
@@ -11,7 +11,96 @@ class MULTIPLAYERPLUGIN_API ALobbyGameMode : public AGameModeBase
 {
 	GENERATED_BODY()
 
+private:
+	/** Minimum time between session updates caused by players joining or leaving */
+	UPROPERTY(EditDefaultsOnly, Category = "Session", meta = (ClampMin = "0.0"))
+	float SessionHeartbeatInterval = 5.f;
+
+	/** How long slots held for a party stay reserved for members that have not arrived yet */
+	UPROPERTY(EditDefaultsOnly, Category = "Session", meta = (ClampMin = "0.0"))
+	float PartyReservationTimeout = 60.f;
+
+	/** Server tick rate while the lobby is empty or nobody has moved for IdleGraceSeconds */
+	UPROPERTY(EditDefaultsOnly, Category = "Tick Policy", meta = (ClampMin = "1"))
+	int32 IdleTickRate = 5;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Tick Policy", meta = (ClampMin = "1"))
+	int32 ActiveTickRate = 30;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Tick Policy", meta = (ClampMin = "0.0"))
+	float IdleGraceSeconds = 10.f;
+
+	/** How often the measured CPU cost of an idle lobby at both rates, and the difference between them, is logged */
+	UPROPERTY(EditDefaultsOnly, Category = "Tick Policy", meta = (ClampMin = "1.0"))
+	float TickStatsLogInterval = 60.f;
+
+	/** Once per TickStatsLogInterval an idle lobby is held at ActiveTickRate for this long, to measure what not throttling it costs */
+	UPROPERTY(EditDefaultsOnly, Category = "Tick Policy", meta = (ClampMin = "1.0"))
+	float TickCalibrationSeconds = 5.f;
+
+private:
+	struct FPartyReservation
+	{
+		int32 ReservedSlots = 0;
+		int32 ArrivedPlayers = 0;
+		double ExpireTime = 0.0;
+
+		FORCEINLINE int32 GetOpenSlots() const { return FMath::Max(ReservedSlots - ArrivedPlayers, 0); }
+	};
+
+private:
+	FTimerHandle SessionHeartbeatTimerHandle;
+	int32 PendingPlayerCount = 0;
+	int32 PublishedPlayerCount = INDEX_NONE;
+	double LastPublishTime = 0.0;
+
+	/** Slots held for parties keyed by party id, so a party either fits as a group or is turned away as one */
+	TMap<FString, FPartyReservation> PartyReservations;
+
+	int32 AppliedTickRate = 0;
+	int32 OriginalTickRate = INDEX_NONE;
+	double LastTickRateChangeTime = 0.0;
+	double LastActivityTime = 0.0;
+	bool bIsLobbyIdle = false;
+	double CalibrationEndTime = 0.0;
+	double NextCalibrationTime = 0.0;
+
+	/** Time the lobby spent idle or active, weighing how much of its life the throttle applies to */
+	double LobbyIdleSeconds = 0.0;
+	double LobbyActiveSeconds = 0.0;
+
+	/** Idle time at each rate and the process CPU time measured over it, in core seconds */
+	double IdleRateWallSeconds = 0.0;
+	double IdleRateCoreSeconds = 0.0;
+	double ActiveRateWallSeconds = 0.0;
+	double ActiveRateCoreSeconds = 0.0;
+	double TickStatsSecondsSinceLog = 0.0;
+
 public:
+	ALobbyGameMode();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Tick(float DeltaSeconds) override;
+	virtual void PreLogin(const FString& Options, const FString& Address, const FUniqueNetIdRepl& UniqueId, FString& ErrorMessage) override;
 	virtual void PostLogin(APlayerController* NewPlayer) override;
 	virtual void Logout(AController* Exiting) override;
+
+private:
+	void OnPlayerCountChanged(const int32 PlayerCount);
+	void PublishPlayerCount();
+	bool IsSessionFull(const int32 PlayerCount) const;
+
+	/** Returns false if the whole party does not fit next to the players and reservations already here */
+	bool ReservePartySlots(const FString& PartyId, const int32 PartySize);
+	void AddPartyReservation(const FString& PartyId, const int32 PartySize);
+	int32 GetOpenReservedSlots() const;
+	void RemoveExpiredPartyReservations();
+
+	bool UsesTickPolicy() const;
+	bool IsAnyPlayerMoving() const;
+	void UpdateTickRate();
+	void ApplyTickRate(const int32 TickRate);
+	void RestoreTickRate();
+	void AccumulateTickStats(const float DeltaSeconds);
 };
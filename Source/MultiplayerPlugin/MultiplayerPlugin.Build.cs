@@ -17,7 +17,8 @@ public class MultiplayerPlugin : ModuleRules
 			"HeadMountedDisplay", 
 			"EnhancedInput",
 			"OnlineSubsystem",
-			"OnlineSubsystemSteam"
+			"OnlineSubsystemSteam",
+			"MultiplayerSessions"
 		});
 	}
 }
@@ -3,5 +3,7 @@
 #include "MultiplayerPlugin.h"
 #include "Modules/ModuleManager.h"
 
+DEFINE_LOG_CATEGORY(LogMultiplayerPlugin);
+
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, MultiplayerPlugin, "MultiplayerPlugin" );
  
\ No newline at end of file
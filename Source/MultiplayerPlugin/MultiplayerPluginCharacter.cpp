@@ -1,6 +1,7 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "MultiplayerPluginCharacter.h"
+#include "MultiplayerPluginMovementComponent.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/InputComponent.h"
@@ -9,12 +10,14 @@
 #include "GameFramework/SpringArmComponent.h"
 #include "EnhancedInputComponent.h"
 #include "EnhancedInputSubsystems.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
 
 
 //////////////////////////////////////////////////////////////////////////
 // AMultiplayerPluginCharacter
 
-AMultiplayerPluginCharacter::AMultiplayerPluginCharacter()
+AMultiplayerPluginCharacter::AMultiplayerPluginCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UMultiplayerPluginMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
 	// Set size for collision capsule
 	GetCapsuleComponent()->InitCapsuleSize(42.f, 96.0f);
@@ -65,6 +68,17 @@ void AMultiplayerPluginCharacter::BeginPlay()
 			Subsystem->AddMappingContext(DefaultMappingContext, 0);
 		}
 	}
+
+	if (bLowLatencyInput)
+	{
+		// Only orders movement, and whatever it already depends on, ahead of the other pre-physics ticks, not earlier in the frame
+		GetCharacterMovement()->PrimaryComponentTick.SetPriorityIncludingPrerequisites(true);
+
+		if (UMultiplayerPluginMovementComponent* MovementComponent = Cast<UMultiplayerPluginMovementComponent>(GetCharacterMovement()))
+		{
+			MovementComponent->bSendMovesImmediately = true;
+		}
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -89,29 +103,49 @@ void AMultiplayerPluginCharacter::SetupPlayerInputComponent(class UInputComponen
 
 void AMultiplayerPluginCharacter::Move(const FInputActionValue& Value)
 {
+	TRACE_CPUPROFILER_EVENT_SCOPE(AMultiplayerPluginCharacter::Move);
+
 	// input is a Vector2D
 	FVector2D MovementVector = Value.Get<FVector2D>();
 
 	if (Controller != nullptr)
 	{
-		// find out which way is forward
+		// find out which way is forward and right
 		const FRotator Rotation = Controller->GetControlRotation();
-		const FRotator YawRotation(0, Rotation.Yaw, 0);
-
-		// get forward vector
-		const FVector ForwardDirection = FRotationMatrix(YawRotation).GetUnitAxis(EAxis::X);
-
-		// get right vector 
-		const FVector RightDirection = FRotationMatrix(YawRotation).GetUnitAxis(EAxis::Y);
+		FVector ForwardDirection;
+		FVector RightDirection;
+		GetYawBasis(Rotation.Yaw, ForwardDirection, RightDirection);
 
 		// add movement 
 		AddMovementInput(ForwardDirection, MovementVector.Y);
 		AddMovementInput(RightDirection, MovementVector.X);
+
+		if (UMultiplayerPluginMovementComponent* MovementComponent = Cast<UMultiplayerPluginMovementComponent>(GetCharacterMovement()))
+		{
+			MovementComponent->RecordMovementInput();
+		}
 	}
 }
 
+void AMultiplayerPluginCharacter::GetYawBasis(const float Yaw, FVector& OutForwardDirection, FVector& OutRightDirection)
+{
+	if (!bLowLatencyInput || !bHasCachedYawBasis || Yaw != CachedBasisYaw)
+	{
+		const FRotationMatrix YawMatrix(FRotator(0, Yaw, 0));
+		CachedForwardDirection = YawMatrix.GetUnitAxis(EAxis::X);
+		CachedRightDirection = YawMatrix.GetUnitAxis(EAxis::Y);
+		CachedBasisYaw = Yaw;
+		bHasCachedYawBasis = true;
+	}
+
+	OutForwardDirection = CachedForwardDirection;
+	OutRightDirection = CachedRightDirection;
+}
+
 void AMultiplayerPluginCharacter::Look(const FInputActionValue& Value)
 {
+	TRACE_CPUPROFILER_EVENT_SCOPE(AMultiplayerPluginCharacter::Look);
+
 	// input is a Vector2D
 	FVector2D LookAxisVector = Value.Get<FVector2D>();
 
@@ -37,8 +37,18 @@ class AMultiplayerPluginCharacter : public ACharacter
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Input, meta = (AllowPrivateAccess = "true"))
 	class UInputAction* LookAction;
 
+	/** Ticks movement first among pre-physics ticks, caches the yaw basis and sends moves without combining delay */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = Input, meta = (AllowPrivateAccess = "true"))
+	bool bLowLatencyInput = false;
+
+	/** Yaw basis reused by Move while the control yaw is unchanged */
+	bool bHasCachedYawBasis = false;
+	float CachedBasisYaw = 0.f;
+	FVector CachedForwardDirection;
+	FVector CachedRightDirection;
+
 public:
-	AMultiplayerPluginCharacter();
+	AMultiplayerPluginCharacter(const FObjectInitializer& ObjectInitializer);
 
 protected:
 	/** Called for movement input */
@@ -46,6 +56,9 @@ protected:
 
 	/** Called for looking input */
 	void Look(const FInputActionValue& Value);
+
+	/** Returns the world forward and right vectors for the given control yaw */
+	void GetYawBasis(const float Yaw, FVector& OutForwardDirection, FVector& OutRightDirection);
 			
 protected:
 	// APawn interface
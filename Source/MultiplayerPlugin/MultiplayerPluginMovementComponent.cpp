@@ -0,0 +1,159 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MultiplayerPluginMovementComponent.h"
+
+#include "MultiplayerPlugin.h"
+#include "GameFramework/Character.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+CSV_DEFINE_CATEGORY(InputLatency, true);
+
+namespace MultiplayerPluginMovement
+{
+	/** Inputs whose move is never acknowledged (dropped, corrected or timestamp reset) stop being tracked after this */
+	constexpr double MaxPendingSampleAge = 2.0;
+
+	float Percentile(const TArray<float>& SortedSamples, const float Fraction)
+	{
+		const int32 Index = FMath::Clamp(FMath::CeilToInt(Fraction * SortedSamples.Num()) - 1, 0, SortedSamples.Num() - 1);
+		return SortedSamples[Index];
+	}
+
+	FString Summarize(TArray<float>& Samples)
+	{
+		if (Samples.IsEmpty())
+		{
+			return TEXT("no samples");
+		}
+
+		Samples.Sort();
+		return FString::Printf(TEXT("n=%d p50=%.2f p95=%.2f p99=%.2f max=%.2f ms"),
+			Samples.Num(), Percentile(Samples, 0.5f), Percentile(Samples, 0.95f), Percentile(Samples, 0.99f), Samples.Last());
+	}
+}
+
+void UMultiplayerPluginMovementComponent::RecordMovementInput()
+{
+	if (!bTrackInputLatency)
+	{
+		return;
+	}
+
+	// Input events are pumped at the start of the frame, so latency is measured from there rather than from this callback
+	const double Now = FPlatformTime::Seconds();
+	const double InputTime = FApp::UseFixedTimeStep() ? Now : FMath::Min(FApp::GetCurrentTime(), Now);
+
+	FPendingInputSample& Sample = PendingInputSamples.AddDefaulted_GetRef();
+	Sample.InputTime = InputTime;
+}
+
+void UMultiplayerPluginMovementComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (!bTrackInputLatency)
+	{
+		return;
+	}
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(UMultiplayerPluginMovementComponent::TrackInputLatency);
+
+	const double Now = FPlatformTime::Seconds();
+	const bool bAwaitsServerAck = CharacterOwner && CharacterOwner->GetLocalRole() == ROLE_AutonomousProxy;
+
+	for (int32 SampleIndex = PendingInputSamples.Num() - 1; SampleIndex >= 0; --SampleIndex)
+	{
+		FPendingInputSample& Sample = PendingInputSamples[SampleIndex];
+		if (!Sample.bConsumed)
+		{
+			Sample.bConsumed = true;
+
+			const float LocalLatencyMs = static_cast<float>((Now - Sample.InputTime) * 1000.0);
+			LocalLatencySamplesMs.Add(LocalLatencyMs);
+			CSV_CUSTOM_STAT(InputLatency, LocalMs, LocalLatencyMs, ECsvCustomStatOp::Set);
+		}
+
+		if (!bAwaitsServerAck || Now - Sample.InputTime > MultiplayerPluginMovement::MaxPendingSampleAge)
+		{
+			PendingInputSamples.RemoveAtSwap(SampleIndex);
+		}
+	}
+
+	if (Now - LastLatencyReportTime >= LatencyReportInterval)
+	{
+		ReportLatency();
+		LastLatencyReportTime = Now;
+	}
+}
+
+void UMultiplayerPluginMovementComponent::ClientAckGoodMove_Implementation(float TimeStamp)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UMultiplayerPluginMovementComponent::ClientAckGoodMove);
+
+	Super::ClientAckGoodMove_Implementation(TimeStamp);
+
+	if (!bTrackInputLatency)
+	{
+		return;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	for (int32 SampleIndex = PendingInputSamples.Num() - 1; SampleIndex >= 0; --SampleIndex)
+	{
+		const FPendingInputSample& Sample = PendingInputSamples[SampleIndex];
+		if (Sample.MoveTimeStamp >= 0.f && Sample.MoveTimeStamp <= TimeStamp)
+		{
+			const float AckedLatencyMs = static_cast<float>((Now - Sample.InputTime) * 1000.0);
+			AckedLatencySamplesMs.Add(AckedLatencyMs);
+			CSV_CUSTOM_STAT(InputLatency, ServerAckedMs, AckedLatencyMs, ECsvCustomStatOp::Set);
+
+			PendingInputSamples.RemoveAtSwap(SampleIndex);
+		}
+	}
+}
+
+void UMultiplayerPluginMovementComponent::ReplicateMoveToServer(float DeltaTime, const FVector& NewAcceleration)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UMultiplayerPluginMovementComponent::ReplicateMoveToServer);
+
+	Super::ReplicateMoveToServer(DeltaTime, NewAcceleration);
+
+	if (!bTrackInputLatency)
+	{
+		return;
+	}
+
+	// The ServerMove carrying this input is identified by the timestamp of the saved move it went into
+	if (const FNetworkPredictionData_Client_Character* ClientData = GetPredictionData_Client_Character())
+	{
+		for (FPendingInputSample& Sample : PendingInputSamples)
+		{
+			if (Sample.MoveTimeStamp < 0.f)
+			{
+				Sample.MoveTimeStamp = ClientData->CurrentTimeStamp;
+			}
+		}
+	}
+}
+
+bool UMultiplayerPluginMovementComponent::CanDelaySendingMove(const FSavedMovePtr& NewMove)
+{
+	return !bSendMovesImmediately && Super::CanDelaySendingMove(NewMove);
+}
+
+void UMultiplayerPluginMovementComponent::ReportLatency()
+{
+	if (LocalLatencySamplesMs.IsEmpty() && AckedLatencySamplesMs.IsEmpty())
+	{
+		return;
+	}
+
+	UE_LOG(LogMultiplayerPlugin, Log, TEXT("Input latency (%s): local %s | server acked %s"),
+		bSendMovesImmediately ? TEXT("low latency") : TEXT("default"),
+		*MultiplayerPluginMovement::Summarize(LocalLatencySamplesMs), *MultiplayerPluginMovement::Summarize(AckedLatencySamplesMs));
+
+	LocalLatencySamplesMs.Reset();
+	AckedLatencySamplesMs.Reset();
+}
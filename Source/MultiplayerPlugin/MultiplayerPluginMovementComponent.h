@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "MultiplayerPluginMovementComponent.generated.h"
+
+/**
+ * Character movement that can measure input-to-motion latency, both until the local move consumes the input
+ * and until the server acknowledges the move that carried it, and can send moves without combining delay.
+ */
+UCLASS()
+class MULTIPLAYERPLUGIN_API UMultiplayerPluginMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+private:
+	struct FPendingInputSample
+	{
+		double InputTime = 0.0;
+		float MoveTimeStamp = -1.f;
+		bool bConsumed = false;
+	};
+
+public:
+	UPROPERTY(EditAnywhere, Category = "Input Latency")
+	bool bTrackInputLatency = false;
+
+	/** How often the latency distributions are logged and reset */
+	UPROPERTY(EditAnywhere, Category = "Input Latency", meta = (ClampMin = "1.0"))
+	float LatencyReportInterval = 10.f;
+
+	/** Send every move as soon as it is made instead of holding it back to be combined with the next one */
+	UPROPERTY(EditAnywhere, Category = "Character Movement (Networking)")
+	bool bSendMovesImmediately = false;
+
+private:
+	TArray<FPendingInputSample> PendingInputSamples;
+	TArray<float> LocalLatencySamplesMs;
+	TArray<float> AckedLatencySamplesMs;
+	double LastLatencyReportTime = 0.0;
+
+public:
+	/**
+	 * Called by the owning character whenever Enhanced Input hands it movement input. Latency is measured from the
+	 * start of the frame the input was pumped in, not from the hardware event, so OS and device delay is not included.
+	 */
+	void RecordMovementInput();
+
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	virtual void ClientAckGoodMove_Implementation(float TimeStamp) override;
+
+protected:
+	virtual void ReplicateMoveToServer(float DeltaTime, const FVector& NewAcceleration) override;
+	virtual bool CanDelaySendingMove(const FSavedMovePtr& NewMove) override;
+
+private:
+	void ReportLatency();
+};